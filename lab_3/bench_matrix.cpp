@@ -0,0 +1,363 @@
+// Matrix multiply benchmark: sweeps sizes, pool sizes, algorithms and element types and
+// reports per-configuration timing statistics as a table, CSV and/or JSON.
+//
+//   bench_matrix [--sizes 64,128,...] [--threads 1,4] [--algorithms naive,blocked,parallel,strassen]
+//                [--types f64,f32,i8] [--pin 0,1] [--placements serial,first-touch,interleave]
+//                [--min-reps N] [--min-time SECONDS] [--naive-max N] [--csv FILE] [--json FILE]
+//
+// Each configuration runs once untimed, then repeats until it has at least --min-reps samples
+// and --min-time seconds of them. GFLOP/s is 2 m n k over the median time. Bandwidth is the
+// compulsory traffic (read A and B, write C once) over the median time, so it is a lower
+// bound on what the run actually pulled from memory.
+//
+// Placements and pinning show the cross-socket cost on NUMA machines: "serial" puts every
+// page on the main thread's node, the layout Matrix used to produce, while first-touch and
+// interleave spread them. The last column is C's sampled page count per node.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "include/Matrix.h"
+#include "include/Gemm.h"
+#include "include/Numa.h"
+#include "include/ThreadPool.h"
+
+namespace {
+
+struct Options {
+    std::vector<size_t> sizes = {64, 128, 256, 512, 1024, 2048, 4096, 8192};
+    std::vector<size_t> threads;
+    std::vector<std::string> algorithms = {"naive", "blocked", "parallel", "strassen"};
+    std::vector<std::string> types = {"f64"};
+    std::vector<bool> pin;
+    std::vector<NumaPlacement> placements;
+    size_t min_reps = 3;
+    double min_time = 0.2;
+    size_t naive_max = 1024;
+    std::string csv_path;
+    std::string json_path;
+};
+
+struct Result {
+    std::string type;
+    std::string algorithm;
+    size_t size;
+    size_t threads;
+    bool pinned;
+    std::string placement;
+    size_t reps;
+    double min_seconds;
+    double median_seconds;
+    double p95_seconds;
+    double gflops;
+    double bandwidth_gbs;
+    std::string node_pages;
+};
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::vector<size_t> split_sizes(const std::string& list) {
+    std::vector<size_t> values;
+    for (const std::string& item : split(list)) {
+        size_t value = std::stoul(item);
+        if (value == 0) {
+            throw std::invalid_argument("Sizes and thread counts must be positive");
+        }
+        values.push_back(value);
+    }
+    return values;
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+        if (arg == "--sizes") {
+            options.sizes = split_sizes(value);
+        } else if (arg == "--threads") {
+            options.threads = split_sizes(value);
+        } else if (arg == "--algorithms") {
+            options.algorithms = split(value);
+        } else if (arg == "--types") {
+            options.types = split(value);
+        } else if (arg == "--pin") {
+            options.pin.clear();
+            for (const std::string& item : split(value)) {
+                options.pin.push_back(item != "0");
+            }
+        } else if (arg == "--placements") {
+            options.placements.clear();
+            for (const std::string& item : split(value)) {
+                if (item == "serial") {
+                    options.placements.push_back(NumaPlacement::Serial);
+                } else if (item == "first-touch") {
+                    options.placements.push_back(NumaPlacement::FirstTouch);
+                } else if (item == "interleave") {
+                    options.placements.push_back(NumaPlacement::Interleave);
+                } else {
+                    throw std::invalid_argument("Unknown placement " + item);
+                }
+            }
+        } else if (arg == "--min-reps") {
+            options.min_reps = std::max<size_t>(1, std::stoul(value));
+        } else if (arg == "--min-time") {
+            options.min_time = std::stod(value);
+        } else if (arg == "--naive-max") {
+            options.naive_max = std::stoul(value);
+        } else if (arg == "--csv") {
+            options.csv_path = value;
+        } else if (arg == "--json") {
+            options.json_path = value;
+        } else {
+            throw std::invalid_argument("Unknown option " + arg);
+        }
+    }
+
+    if (options.threads.empty()) {
+        // The pool's default size, and a single thread for comparison.
+        size_t all = ThreadPool::global().size();
+        options.threads = all > 1 ? std::vector<size_t>{1, all} : std::vector<size_t>{1};
+    }
+    if (options.pin.empty()) {
+        options.pin.push_back(ThreadPool::global().pinned());
+    }
+    if (options.placements.empty()) {
+        options.placements.push_back(numa_placement());
+    }
+    return options;
+}
+
+// Nearest-rank percentile of sorted samples.
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+double median(const std::vector<double>& sorted) {
+    size_t mid = sorted.size() / 2;
+    return sorted.size() % 2 ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2;
+}
+
+std::vector<double> measure(const std::function<void()>& run, const Options& options) {
+    using clock = std::chrono::steady_clock;
+    run();
+
+    std::vector<double> samples;
+    double total = 0;
+    while (samples.size() < options.min_reps || total < options.min_time) {
+        auto start = clock::now();
+        run();
+        double seconds = std::chrono::duration<double>(clock::now() - start).count();
+        samples.push_back(seconds);
+        total += seconds;
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples;
+}
+
+std::string node_pages(const void* data, size_t bytes) {
+    // Every 16th page is plenty to see the split and keeps 8192^2 runs quick.
+    std::vector<size_t> pages = numa_page_histogram(data, bytes, 16);
+    std::string text;
+    for (size_t node = 0; node < pages.size(); ++node) {
+        if (node > 0) {
+            text += '/';
+        }
+        text += std::to_string(pages[node]);
+    }
+    return text.empty() ? "-" : text;
+}
+
+void print_result(const Result& r) {
+    std::cout << std::left << std::setw(5) << r.type << std::setw(10) << r.algorithm
+              << std::right << std::setw(6) << r.size << std::setw(5) << r.threads
+              << std::setw(5) << (r.pinned ? "yes" : "no") << std::setw(13) << r.placement
+              << std::setw(6) << r.reps << std::fixed << std::setprecision(6)
+              << std::setw(12) << r.median_seconds << std::setw(12) << r.p95_seconds
+              << std::setprecision(2) << std::setw(10) << r.gflops
+              << std::setw(10) << r.bandwidth_gbs << "  " << r.node_pages << "\n"
+              << std::defaultfloat << std::flush;
+}
+
+// Runs every algorithm for one element type and size under one pool and placement, with
+// the matrices allocated afresh so that their pages follow that placement.
+template <typename T>
+void bench_config(const std::string& type, size_t n, size_t threads, bool pin, NumaPlacement placement,
+                  bool first_config, const Options& options, std::vector<Result>& results) {
+    using Acc = gemm_acc_t<T>;
+    ThreadPool::set_global_size(threads, pin);
+    numa_set_placement(placement);
+
+    Matrix<T> a(n, n), b(n, n);
+    if constexpr (std::is_integral_v<T>) {
+        a.fill_random(-100, 100);
+        b.fill_random(-100, 100);
+    } else {
+        a.fill_random(-1, 1);
+        b.fill_random(-1, 1);
+    }
+    Matrix<Acc> c(n, n);
+    std::string pages = node_pages(c.data(), n * n * sizeof(Acc));
+
+    double flops = 2.0 * n * n * n;
+    double bytes = 2.0 * n * n * sizeof(T) + 1.0 * n * n * sizeof(Acc);
+
+    for (const std::string& algorithm : options.algorithms) {
+        std::function<void()> run;
+        bool threaded = false;
+        if (algorithm == "naive") {
+            if (n > options.naive_max) {
+                continue;
+            }
+            run = [&] { gemm_reference(n, n, n, a.data(), n, b.data(), n, c.data(), n); };
+        } else if (algorithm == "blocked") {
+            run = [&] { Matrix<T>::multiply(a.view(), b.view(), c.view()); };
+        } else if (algorithm == "parallel") {
+            run = [&] { Matrix<T>::parallel_multiply(a.view(), b.view(), c.view()); };
+            threaded = true;
+        } else if (algorithm == "strassen") {
+            if constexpr (std::is_floating_point_v<T>) {
+                run = [&] { Matrix<T>::strassen_multiply(a.view(), b.view(), c.view()); };
+                threaded = true;
+            } else {
+                continue;
+            }
+        } else {
+            throw std::invalid_argument("Unknown algorithm " + algorithm);
+        }
+
+        // Single-threaded algorithms only run under the first thread count and pinning choice.
+        if (!threaded && !first_config) {
+            continue;
+        }
+
+        std::vector<double> samples = measure(run, options);
+        Result result{type, algorithm, n, threaded ? threads : 1, pin, numa_placement_name(placement),
+                      samples.size(), samples.front(), median(samples), percentile(samples, 0.95), 0, 0, pages};
+        result.gflops = flops / result.median_seconds * 1e-9;
+        result.bandwidth_gbs = bytes / result.median_seconds * 1e-9;
+        results.push_back(result);
+        print_result(result);
+    }
+}
+
+template <typename T>
+void bench_size(const std::string& type, size_t n, const Options& options, std::vector<Result>& results) {
+    for (size_t threads : options.threads) {
+        for (bool pin : options.pin) {
+            bool first_config = threads == options.threads.front() && pin == options.pin.front();
+            for (NumaPlacement placement : options.placements) {
+                bench_config<T>(type, n, threads, pin, placement, first_config, options, results);
+            }
+        }
+    }
+}
+
+void write_csv(const std::string& path, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Failed to open " + path + " for writing");
+    }
+    out << "type,algorithm,size,threads,pinned,placement,reps,min_s,median_s,p95_s,gflops,bandwidth_gbs,node_pages\n";
+    out << std::setprecision(9);
+    for (const Result& r : results) {
+        out << r.type << ',' << r.algorithm << ',' << r.size << ',' << r.threads << ',' << r.pinned << ','
+            << r.placement << ',' << r.reps << ',' << r.min_seconds << ',' << r.median_seconds << ','
+            << r.p95_seconds << ',' << r.gflops << ',' << r.bandwidth_gbs << ',' << r.node_pages << '\n';
+    }
+}
+
+void write_json(const std::string& path, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("Failed to open " + path + " for writing");
+    }
+
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    out << std::setprecision(9);
+    out << "{\n  \"host\": \"" << host << "\",\n"
+        << "  \"timestamp\": " << std::time(nullptr) << ",\n"
+        << "  \"isa\": \"" << gemm_isa_name() << "\",\n"
+        << "  \"numa_nodes\": " << numa_node_count() << ",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"type\": \"" << r.type << "\", \"algorithm\": \"" << r.algorithm
+            << "\", \"size\": " << r.size << ", \"threads\": " << r.threads
+            << ", \"pinned\": " << (r.pinned ? "true" : "false") << ", \"placement\": \"" << r.placement
+            << "\", \"reps\": " << r.reps
+            << ", \"min_s\": " << r.min_seconds << ", \"median_s\": " << r.median_seconds
+            << ", \"p95_s\": " << r.p95_seconds << ", \"gflops\": " << r.gflops
+            << ", \"bandwidth_gbs\": " << r.bandwidth_gbs << ", \"node_pages\": \"" << r.node_pages << "\"}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parse_options(argc, argv);
+
+        std::cout << "GEMM kernel: " << gemm_isa_name() << ", NUMA nodes: " << numa_node_count() << "\n";
+        std::cout << std::left << std::setw(5) << "type" << std::setw(10) << "algorithm" << std::right
+                  << std::setw(6) << "size" << std::setw(5) << "thr" << std::setw(5) << "pin"
+                  << std::setw(13) << "placement" << std::setw(6) << "reps"
+                  << std::setw(12) << "median_s" << std::setw(12) << "p95_s"
+                  << std::setw(10) << "GFLOP/s" << std::setw(10) << "GB/s" << "  pages/node\n";
+
+        std::vector<Result> results;
+        for (const std::string& type : options.types) {
+            for (size_t n : options.sizes) {
+                if (type == "f64") {
+                    bench_size<double>(type, n, options, results);
+                } else if (type == "f32") {
+                    bench_size<float>(type, n, options, results);
+                } else if (type == "i8") {
+                    bench_size<int8_t>(type, n, options, results);
+                } else {
+                    throw std::invalid_argument("Unknown type " + type);
+                }
+            }
+        }
+
+        if (!options.csv_path.empty()) {
+            write_csv(options.csv_path, results);
+        }
+        if (!options.json_path.empty()) {
+            write_json(options.json_path, results);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
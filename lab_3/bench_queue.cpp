@@ -0,0 +1,250 @@
+// ThreadSafeQueue benchmark: producers hand items to consumers through one queue and the
+// table reports hand-offs per second for every queue policy and thread count.
+//
+//   bench_queue [--threads 1,2,4,8,16,32,64] [--policies mutex,mpmc,mpsc,spsc] [--items N]
+//               [--capacity N] [--batch N] [--spins N] [--reps N]
+//
+// --threads is the number of producers, with as many consumers, except that a policy with a
+// single-threaded side runs that side on one thread (so spsc runs once, 1 to 1). Every run
+// moves --items items in total; the rate is items over the median wall time from the start
+// barrier until the last consumer has seen the queue closed. With --batch above 1 both
+// sides move up to that many items per call through enqueue_bulk / dequeue_bulk. --spins
+// caps how long a blocked side spins before it parks (QueueWait::adaptive); 0 parks at once.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <pthread.h>
+
+#include "include/ThreadSafeQueue.h"
+#include "include/check.hpp"
+
+namespace {
+
+struct Options {
+    std::vector<size_t> threads = {1, 2, 4, 8, 16, 32, 64};
+    std::vector<std::string> policies = {"mutex", "mpmc", "mpsc", "spsc"};
+    size_t items = 2000000;
+    size_t capacity = 1024;
+    size_t batch = 1;
+    uint32_t spins = QueueWait::adaptive().max_spins;
+    size_t reps = 3;
+};
+
+std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+size_t parse_positive(const std::string& value) {
+    size_t result = std::stoul(value);
+    if (result == 0) {
+        throw std::invalid_argument("Counts must be positive");
+    }
+    return result;
+}
+
+Options parse_options(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            throw std::invalid_argument("Missing value for " + arg);
+        }
+        std::string value = argv[++i];
+        if (arg == "--threads") {
+            options.threads.clear();
+            for (const std::string& item : split(value)) {
+                options.threads.push_back(parse_positive(item));
+            }
+        } else if (arg == "--policies") {
+            options.policies = split(value);
+        } else if (arg == "--items") {
+            options.items = parse_positive(value);
+        } else if (arg == "--capacity") {
+            options.capacity = parse_positive(value);
+        } else if (arg == "--batch") {
+            options.batch = parse_positive(value);
+        } else if (arg == "--spins") {
+            options.spins = static_cast<uint32_t>(std::stoul(value));
+        } else if (arg == "--reps") {
+            options.reps = parse_positive(value);
+        } else {
+            throw std::invalid_argument("Unknown option " + arg);
+        }
+    }
+    return options;
+}
+
+// Which sides of a policy's queue may be used by several threads.
+template <typename Policy>
+struct Topology {
+    static constexpr bool many_producers = true;
+    static constexpr bool many_consumers = true;
+};
+
+template <>
+struct Topology<queue_policy::Mpsc> {
+    static constexpr bool many_producers = true;
+    static constexpr bool many_consumers = false;
+};
+
+template <>
+struct Topology<queue_policy::Spsc> {
+    static constexpr bool many_producers = false;
+    static constexpr bool many_consumers = false;
+};
+
+template <typename Queue>
+struct Run {
+    Queue* queue;
+    pthread_barrier_t* start;
+    size_t items;  // per producer; 0 for consumers
+    size_t batch;
+};
+
+template <typename Queue>
+void* producer_main(void* arg) {
+    auto* run = static_cast<Run<Queue>*>(arg);
+    pthread_barrier_wait(run->start);
+    if (run->batch == 1) {
+        for (size_t i = 1; i <= run->items; ++i) {
+            run->queue->enqueue(static_cast<uint64_t>(i));
+        }
+        return nullptr;
+    }
+    std::vector<uint64_t> batch(run->batch);
+    for (size_t i = 1; i <= run->items; i += run->batch) {
+        size_t count = std::min(run->batch, run->items - i + 1);
+        for (size_t j = 0; j < count; ++j) {
+            batch[j] = i + j;
+        }
+        run->queue->enqueue_bulk(std::span<uint64_t>(batch.data(), count));
+    }
+    return nullptr;
+}
+
+template <typename Queue>
+void* consumer_main(void* arg) {
+    auto* run = static_cast<Run<Queue>*>(arg);
+    pthread_barrier_wait(run->start);
+    if (run->batch == 1) {
+        while (run->queue->dequeue()) {
+        }
+        return nullptr;
+    }
+    std::vector<uint64_t> batch(run->batch);
+    while (run->queue->dequeue_bulk(batch) != 0) {
+    }
+    return nullptr;
+}
+
+template <typename Policy>
+double run_once(size_t num_producers, size_t num_consumers, const Options& options) {
+    ThreadSafeQueue<uint64_t, Policy> queue(options.capacity, QueueWait::adaptive(options.spins));
+    pthread_barrier_t start;
+    check_result(pthread_barrier_init(&start, nullptr, static_cast<unsigned>(num_producers + num_consumers + 1)));
+
+    using Queue = ThreadSafeQueue<uint64_t, Policy>;
+    std::vector<Run<Queue>> producers(num_producers, Run<Queue>{&queue, &start, options.items / num_producers, options.batch});
+    std::vector<Run<Queue>> consumers(num_consumers, Run<Queue>{&queue, &start, 0, options.batch});
+    producers[0].items += options.items % num_producers;
+
+    std::vector<pthread_t> producer_threads(num_producers);
+    std::vector<pthread_t> consumer_threads(num_consumers);
+    for (size_t i = 0; i < num_consumers; ++i) {
+        check_result(pthread_create(&consumer_threads[i], nullptr, consumer_main<Queue>, &consumers[i]));
+    }
+    for (size_t i = 0; i < num_producers; ++i) {
+        check_result(pthread_create(&producer_threads[i], nullptr, producer_main<Queue>, &producers[i]));
+    }
+
+    pthread_barrier_wait(&start);
+    auto begin = std::chrono::steady_clock::now();
+    for (pthread_t thread : producer_threads) {
+        check_result(pthread_join(thread, nullptr));
+    }
+    queue.set_done();
+    for (pthread_t thread : consumer_threads) {
+        check_result(pthread_join(thread, nullptr));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    check_result(pthread_barrier_destroy(&start));
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+template <typename Policy>
+double median_seconds(size_t num_producers, size_t num_consumers, const Options& options) {
+    std::vector<double> samples;
+    for (size_t r = 0; r < options.reps; ++r) {
+        samples.push_back(run_once<Policy>(num_producers, num_consumers, options));
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+template <typename Policy>
+void bench_policy(const std::string& name, const Options& options) {
+    std::vector<std::pair<size_t, size_t>> done;
+    for (size_t threads : options.threads) {
+        size_t num_producers = Topology<Policy>::many_producers ? threads : 1;
+        size_t num_consumers = Topology<Policy>::many_consumers ? threads : 1;
+        if (std::find(done.begin(), done.end(), std::make_pair(num_producers, num_consumers)) != done.end()) {
+            continue;
+        }
+        done.emplace_back(num_producers, num_consumers);
+
+        double seconds = median_seconds<Policy>(num_producers, num_consumers, options);
+        std::cout << std::left << std::setw(8) << name << std::right << std::setw(6) << num_producers
+                  << std::setw(6) << num_consumers << std::setw(12) << std::fixed << std::setprecision(4)
+                  << seconds << std::setw(14) << std::setprecision(2) << options.items / seconds / 1e6 << "\n";
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parse_options(argc, argv);
+
+        std::cout << "items: " << options.items << ", capacity: " << options.capacity
+                  << ", batch: " << options.batch << ", spins: " << options.spins << "\n";
+        std::cout << std::left << std::setw(8) << "policy" << std::right << std::setw(6) << "prod"
+                  << std::setw(6) << "cons" << std::setw(12) << "median_s" << std::setw(14) << "Mops/s" << "\n";
+
+        for (const std::string& policy : options.policies) {
+            if (policy == "mutex") {
+                bench_policy<queue_policy::Mutex>(policy, options);
+            } else if (policy == "mpmc") {
+                bench_policy<queue_policy::Mpmc>(policy, options);
+            } else if (policy == "mpsc") {
+                bench_policy<queue_policy::Mpsc>(policy, options);
+            } else if (policy == "spsc") {
+                bench_policy<queue_policy::Spsc>(policy, options);
+            } else {
+                throw std::invalid_argument("Unknown policy " + policy);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
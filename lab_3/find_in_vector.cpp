@@ -1,45 +1,19 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <numeric>
 #include <vector>
-#include <pthread.h>
 #include <cstdlib>
 #include <ctime>
 #include <fcntl.h>
 #include <unistd.h>
 
+#include "include/ColumnFile.h"
+#include "include/ColumnIndex.h"
+#include "include/Search.h"
+#include "include/ThreadPool.h"
 #include "include/check.hpp"
 
-struct ThreadData {
-    const std::vector<int>& array;
-    int target;
-    std::vector<int>& results;
-    pthread_mutex_t& mutex;
-    int& current_index;
-};
-
-void* search_element(void* arg) {
-    ThreadData* data = (ThreadData*)arg;
-
-    while (true) {
-        check_result(pthread_mutex_lock(&data->mutex));
-
-        int index = data->current_index;
-        if (index >= data->array.size()) {
-            check_result(pthread_mutex_unlock(&data->mutex));
-            break;
-        }
-        data->current_index++;
-        check_result(pthread_mutex_unlock(&data->mutex));
-
-        if (data->array[index] == data->target) {
-            check_result(pthread_mutex_lock(&data->mutex));
-            data->results.push_back(index);
-            check_result(pthread_mutex_unlock(&data->mutex));
-        }
-    }
-
-    return nullptr;
-}
-
 std::vector<int> search(const std::vector<int>& array, int target) {
     std::vector<int> results;
     for (int i = 0; i < array.size(); ++i) {
@@ -50,27 +24,9 @@ std::vector<int> search(const std::vector<int>& array, int target) {
     return results;
 }
 
-std::vector<int> parallel_search(const std::vector<int>& array, int target, int num_threads) {
-    std::vector<int> results;
-    int current_index = 0;
-
-    pthread_mutex_t mutex;
-    check_result(pthread_mutex_init(&mutex, nullptr));
-
-    ThreadData thread_data = {array, target, results, mutex, current_index};
-
-    std::vector<pthread_t> threads(num_threads);
-    for (int i = 0; i < num_threads; ++i) {
-        check_result(pthread_create(&threads[i], nullptr, search_element, &thread_data));
-    }
-
-    for (int i = 0; i < num_threads; ++i) {
-        check_result(pthread_join(threads[i], nullptr));
-    }
-
-    check_result(pthread_mutex_destroy(&mutex));
-
-    return results;
+// Chunked scan on the shared pool (see Search.h); num_threads caps the workers used.
+std::vector<size_t> parallel_search(const std::vector<int>& array, int target, int num_threads) {
+    return search_find(array.data(), array.size(), SearchPredicate::equal(target), num_threads);
 }
 
 void write_to_file(const std::vector<int>& vec, const char* filename) {
@@ -128,11 +84,10 @@ int main() {
     const char* filename = "data.bin";
 
     write_to_file(array, filename);
-    std::vector<int> tmp;
-    read_to_file(tmp, filename);
 
     const int target = 8;
     const int num_threads = 4;
+    ThreadPool::set_global_size(num_threads);
 
     std::cout << "Размер массива:  " << array.size() << std::endl;
 
@@ -144,11 +99,84 @@ int main() {
     std::cout << "Число " << target << " найден " << result.size() << " раз" << std::endl;
 
     auto p_start = std::chrono::high_resolution_clock::now();
-    std::vector<int> result_indices = parallel_search(array, target, num_threads);
+    std::vector<size_t> result_indices = parallel_search(array, target, num_threads);
     auto p_end = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> p_sequential_time = p_end - p_start;
     std::cout << "Parallel search time: " << p_sequential_time.count() << std::endl;
     std::cout << "Число " << target << " найден " << result_indices.size() << " раз" << std::endl;
+    std::cout << "Matches sequential search: " << (std::equal(result.begin(), result.end(), result_indices.begin(),
+                                                              result_indices.end()) ? "yes" : "no") << std::endl;
+
+    // Count-only scans never materialize indices
+    auto c_start = std::chrono::high_resolution_clock::now();
+    size_t count = search_count(array.data(), array.size(), SearchPredicate::equal(target));
+    size_t in_range = search_count(array.data(), array.size(), SearchPredicate::range(10, 19));
+    size_t any = search_count(array.data(), array.size(), SearchPredicate::any_of({8, 42, 99}));
+    auto c_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> count_time = c_end - c_start;
+    std::cout << "Count-only scans time (3 queries): " << count_time.count() << std::endl;
+    std::cout << "Равно " << target << ": " << count << ", в [10, 19]: " << in_range
+              << ", одно из {8, 42, 99}: " << any << std::endl;
+
+    // Many targets at once: one pass over the array instead of one per target
+    std::vector<int> targets;
+    for (int t = 0; t < 100; t += 3) {
+        targets.push_back(t);
+    }
+    auto s_start = std::chrono::high_resolution_clock::now();
+    size_t separate_total = 0;
+    for (int t : targets) {
+        separate_total += search_count(array.data(), array.size(), SearchPredicate::equal(t));
+    }
+    auto s_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> separate_time = s_end - s_start;
+    auto b_start = std::chrono::high_resolution_clock::now();
+    std::vector<size_t> batch_counts = search_count_many(array.data(), array.size(), targets);
+    auto b_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> batch_time = b_end - b_start;
+    size_t batch_total = std::accumulate(batch_counts.begin(), batch_counts.end(), size_t(0));
+    std::cout << targets.size() << " separate count scans time: " << separate_time.count() << std::endl;
+    std::cout << "Batched count time (" << targets.size() << " targets, one pass): " << batch_time.count() << std::endl;
+    std::cout << "Всего совпадений: " << batch_total << ", совпадает: " << (batch_total == separate_total ? "да" : "нет")
+              << std::endl;
+
+    // Loading the file first versus scanning the mapped pages in place
+    auto l_start = std::chrono::high_resolution_clock::now();
+    std::vector<int> loaded;
+    read_to_file(loaded, filename);
+    std::vector<size_t> loaded_indices = parallel_search(loaded, target, num_threads);
+    auto l_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> load_time = l_end - l_start;
+    std::cout << "Read file + search time: " << load_time.count() << std::endl;
+
+    auto m_start = std::chrono::high_resolution_clock::now();
+    ColumnFile column(filename);
+    std::vector<size_t> mapped_indices = column.find(SearchPredicate::equal(target), num_threads);
+    auto m_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mapped_time = m_end - m_start;
+    std::cout << "Mapped file search time: " << mapped_time.count() << std::endl;
+    std::cout << "Число " << target << " найден " << mapped_indices.size() << " раз, совпадает: "
+              << (mapped_indices == loaded_indices ? "да" : "нет") << std::endl;
+
+    // Zone maps and per-value bitmaps saved next to the data (data.bin.idx): built once per
+    // version of the file, then repeated queries skip the scan
+    auto i_start = std::chrono::high_resolution_clock::now();
+    ColumnIndex index = ColumnIndex::open(filename);
+    auto i_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> index_time = i_end - i_start;
+    std::cout << "Index open/build time: " << index_time.count() << " (" << index.blocks() << " блоков, битовые карты: "
+              << (index.has_bitmaps() ? "да" : "нет") << ")" << std::endl;
+
+    auto q_start = std::chrono::high_resolution_clock::now();
+    std::vector<size_t> indexed_indices = index.find(SearchPredicate::equal(target));
+    size_t indexed_in_range = index.count(SearchPredicate::range(10, 19));
+    size_t indexed_any = index.count(SearchPredicate::any_of({8, 42, 99}));
+    auto q_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> query_time = q_end - q_start;
+    std::cout << "Indexed queries time (3 queries): " << query_time.count() << std::endl;
+    std::cout << "Совпадает с полным сканированием: "
+              << (indexed_indices == mapped_indices && indexed_in_range == in_range && indexed_any == any ? "да" : "нет")
+              << std::endl;
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef COLUMN_FILE_H
+#define COLUMN_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Search.h"
+
+// A raw file of native-endian int32 values with no header (what find_in_vector writes to
+// data.bin), scanned in place through a read-only mapping instead of being read into a
+// vector first. Nothing is loaded up front, so a search starts on the first pages while the
+// kernel reads ahead. The access pattern is passed to the kernel as a hint (by default
+// MADV_SEQUENTIAL, for more readahead and earlier reclaim); the file is never copied, so
+// memory use is whatever the page cache keeps of it.
+class ColumnFile {
+  std::shared_ptr<MappedFile> _file;
+
+public:
+  // Throws std::runtime_error if the file cannot be mapped or is not a whole number of int32.
+  explicit ColumnFile(const std::string& filename, MappedFile::Access access = MappedFile::Access::Sequential);
+
+  const int32_t* data() const;
+  size_t size() const;
+
+  // search_count / search_find over the mapped values.
+  size_t count(const SearchPredicate& predicate, size_t num_threads = 0) const;
+  std::vector<size_t> find(const SearchPredicate& predicate, size_t num_threads = 0) const;
+  // search_count_many / search_find_many: many targets in one pass over the mapping.
+  std::vector<size_t> count_many(const std::vector<int32_t>& targets, size_t num_threads = 0) const;
+  std::vector<std::vector<size_t>> find_many(const std::vector<int32_t>& targets, size_t num_threads = 0) const;
+};
+
+#endif
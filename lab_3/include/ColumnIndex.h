@@ -0,0 +1,95 @@
+#ifndef COLUMN_INDEX_H
+#define COLUMN_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ColumnFile.h"
+#include "MappedFile.h"
+#include "Search.h"
+
+// Secondary index over a ColumnFile for repeated point and range queries, persisted next to
+// the data file (see path_for). The column is cut into blocks of INDEX_BLOCK values:
+//  - a zone map keeps every block's min and max, so a query skips blocks it cannot match and
+//    takes blocks that lie wholly inside a range without looking at them;
+//  - columns with at most max_distinct distinct values (e.g. rand() % 100) also get one
+//    compressed bitmap per value, built roaring-style from one container per block: a sorted
+//    array of 16-bit offsets while it has at most INDEX_ARRAY_MAX entries, else a plain
+//    65536-bit bitmap. Queries are then answered from the bitmaps alone, counts from the
+//    stored cardinalities without touching the column at all.
+// Blocks that neither structure settles are scanned with the search kernels.
+constexpr size_t INDEX_BLOCK = SEARCH_CHUNK;
+constexpr size_t INDEX_ARRAY_MAX = 4096;
+constexpr size_t INDEX_MAX_DISTINCT = 256;
+
+class ColumnIndex {
+public:
+  struct Zone {
+    int32_t min;
+    int32_t max;
+  };
+
+private:
+  struct Container {
+    uint32_t cardinality;
+    uint32_t reserved;
+    uint64_t offset;  // into the payload; unused when empty
+  };
+
+  ColumnFile _column;
+  uint64_t _data_version;
+  std::vector<Zone> _zones;
+  std::vector<int32_t> _values;         // sorted; empty without bitmaps
+  std::vector<Container> _directory;    // _values.size() x blocks(), value-major
+  std::vector<char> _owned_payload;     // built in memory ...
+  std::shared_ptr<MappedFile> _mapping; // ... or mapped from the index file
+  size_t _payload_offset;               // into the mapping
+
+  ColumnIndex(ColumnFile column);
+
+  // Derived on each use so that copies of a built index read their own payload.
+  const char* payload() const;
+  size_t payload_size() const;
+  const Container& container(size_t value, size_t block) const;
+  // Appends the offsets in one container to out, or ORs them into bits.
+  void container_offsets(const Container& c, std::vector<uint32_t>& out) const;
+  void container_or(const Container& c, uint64_t* bits) const;
+  // Indices into _values of the values the predicate selects.
+  std::vector<size_t> selected_values(const SearchPredicate& predicate) const;
+  bool zone_may_match(const Zone& zone, const SearchPredicate& predicate) const;
+  bool zone_all_match(const Zone& zone, const SearchPredicate& predicate) const;
+  size_t block_size(size_t block) const;
+
+public:
+  // Scans the column (in parallel on the pool) for the zone map and each block's distinct
+  // values and, if the column has few enough of them, scans it a second time to fill the
+  // bitmaps' containers.
+  static ColumnIndex build(const ColumnFile& column, size_t max_distinct = INDEX_MAX_DISTINCT);
+  // Maps an index saved by save(); throws std::runtime_error if it is malformed (including
+  // container offsets outside their block) or does not describe column.
+  static ColumnIndex load(const std::string& filename, const ColumnFile& column);
+  // Maps data_file and loads its index from path_for(data_file) if that was saved for the
+  // file's current modification time; otherwise builds the index and saves it there. Index
+  // queries jump between blocks, so the column is mapped with Access::Normal.
+  static ColumnIndex open(const std::string& data_file, size_t max_distinct = INDEX_MAX_DISTINCT);
+  static std::string path_for(const std::string& data_file);
+
+  // Writes the index to a temporary file renamed over filename, so readers never see half
+  // an index. data_version is stored for open() to recognize a stale index.
+  void save(const std::string& filename, uint64_t data_version = 0) const;
+
+  const ColumnFile& column() const;
+  uint64_t data_version() const;
+  size_t blocks() const;
+  bool has_bitmaps() const;
+  const std::vector<Zone>& zones() const;
+
+  // Same results as search_count / search_find over the column.
+  size_t count(const SearchPredicate& predicate, size_t num_threads = 0) const;
+  std::vector<size_t> find(const SearchPredicate& predicate, size_t num_threads = 0) const;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-element-type GEMM parameters. Quantized int8 accumulates in int32 and is packed as
+// int16 pairs of consecutive k (K_GROUP = 2) so SIMD kernels can use multiply-add-pairs.
+template <typename T>
+struct GemmTraits {
+  using Acc = T;
+  using Packed = T;
+  static constexpr size_t K_GROUP = 1;
+};
+
+template <>
+struct GemmTraits<int8_t> {
+  using Acc = int32_t;
+  using Packed = int16_t;
+  static constexpr size_t K_GROUP = 2;
+};
+
+template <typename T>
+using gemm_acc_t = typename GemmTraits<T>::Acc;
+
+// Row-major C[m x n] = A[m x k] * B[k x n]; lda/ldb/ldc are row strides in elements.
+// Cache-blocked (NC/KC/MC) with packed panels of A and B and an MR x NR register kernel
+// selected at runtime from the CPU features (see gemm_set_isa).
+// Instantiated for float, double, int8_t (int32_t result) and int32_t.
+template <typename T>
+void gemm_blocked(size_t m, size_t n, size_t k,
+                  const T* a, size_t lda,
+                  const T* b, size_t ldb,
+                  gemm_acc_t<T>* c, size_t ldc);
+
+// BLAS-style c = alpha * a * b + beta * c on the same blocked kernels: alpha is folded into
+// the packing of A and beta into the first pass over C, so no temporary is formed. With
+// beta == 0, c is only written, as in BLAS. For float, double and int32_t.
+template <typename T>
+void gemm(size_t m, size_t n, size_t k,
+          T alpha,
+          const T* a, size_t lda,
+          const T* b, size_t ldb,
+          T beta,
+          T* c, size_t ldc);
+
+// count independent products c[i] = a[i] * b[i] over contiguous batches: a[i] starts at
+// a + i * m * k, b[i] at b + i * k * n and c[i] at c + i * m * n, each densely row-major.
+// For small matrices (n up to GEMM_BATCH_MAX_N) each product runs without packing, in
+// kernels with compile-time extents for the common sizes (see GemmSmallKernels.h) chosen
+// by gemm_set_isa like the blocked ones; larger matrices fall back to gemm_blocked. The
+// batch is split across ThreadPool::global() in chunks, never a single product;
+// num_threads caps the workers, 0 means the whole pool.
+constexpr size_t GEMM_BATCH_MAX_N = 64;
+
+template <typename T>
+void gemm_batched(size_t count, size_t m, size_t n, size_t k,
+                  const T* a, const T* b, gemm_acc_t<T>* c, size_t num_threads = 0);
+
+// Straightforward i-j-k loop, kept as the correctness reference for gemm_blocked.
+template <typename T>
+void gemm_reference(size_t m, size_t n, size_t k,
+                    const T* a, size_t lda,
+                    const T* b, size_t ldb,
+                    gemm_acc_t<T>* c, size_t ldc);
+
+// Strassen-Winograd: 7 half-size products per level instead of 8, recursing until a dimension
+// drops below crossover and then calling gemm_blocked; odd edges are peeled off and done
+// directly. The first level runs its seven products on ThreadPool::global() unless called
+// from inside a pool task. crossover 0 means the default, 1024, or MATRIX_STRASSEN_CROSSOVER.
+// Scratch comes from a per-thread arena that is reused across calls: about 0.7 n^2 elements
+// for an n x n product, about 4 n^2 when the first level runs in parallel.
+// Trades some accuracy for speed, so it is instantiated for float and double only.
+template <typename T>
+void gemm_strassen(size_t m, size_t n, size_t k,
+                   const T* a, size_t lda,
+                   const T* b, size_t ldb,
+                   T* c, size_t ldc,
+                   size_t crossover = 0);
+
+enum class GemmIsa { Auto, Generic, Sse2, Avx2, Avx512 };
+
+// Forces the micro-kernels used by gemm_blocked (and the batched GEMM and search kernels);
+// Auto picks the widest ones the CPU supports.
+// Element types without a kernel for the chosen ISA use the next narrower one.
+// The initial choice can be overridden with MATRIX_ISA=generic|sse2|avx2|avx512.
+// Throws std::invalid_argument if the CPU cannot run the requested ISA.
+void gemm_set_isa(GemmIsa isa);
+// The ISA in use; never Auto.
+GemmIsa gemm_isa();
+const char* gemm_isa_name();
+
+#endif
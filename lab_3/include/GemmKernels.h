@@ -0,0 +1,39 @@
+#ifndef GEMM_KERNELS_H
+#define GEMM_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Gemm.h"
+
+// Register micro-kernel: C[mr x nr] (+)= A_panel * B_panel over `steps` groups of
+// K_GROUP consecutive k, where A is packed in mr-row micro-panels and B in nr-column
+// micro-panels (see GemmTraits for the packed element type).
+template <typename T>
+struct GemmKernel {
+  using Packed = typename GemmTraits<T>::Packed;
+  using Acc = typename GemmTraits<T>::Acc;
+
+  const char* name;
+  size_t mr;
+  size_t nr;
+  void (*run)(size_t steps, const Packed* a, const Packed* b, Acc* c, size_t ldc, bool accumulate);
+};
+
+#ifdef MATRIX_X86_KERNELS
+// Each group lives in its own translation unit built with the matching -m flags,
+// so they must only be called after a CPUID check.
+extern const GemmKernel<double> gemm_kernel_sse2_f64;
+extern const GemmKernel<float> gemm_kernel_sse2_f32;
+
+extern const GemmKernel<double> gemm_kernel_avx2_f64;
+extern const GemmKernel<float> gemm_kernel_avx2_f32;
+extern const GemmKernel<int8_t> gemm_kernel_avx2_i8;
+
+extern const GemmKernel<double> gemm_kernel_avx512_f64;
+extern const GemmKernel<float> gemm_kernel_avx512_f32;
+// Needs AVX-512BW on top of AVX-512F.
+extern const GemmKernel<int8_t> gemm_kernel_avx512_i8;
+#endif
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef GEMM_SMALL_KERNELS_H
+#define GEMM_SMALL_KERNELS_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "Gemm.h"
+
+// Kernels behind gemm_batched: products first .. last - 1 of a contiguous batch, each
+// c = a * b with no packing. Row widths 4, 8, 16, 32 and 64 get fixed-size kernels; other
+// n up to GEMM_BATCH_MAX_N use a plain loop.
+template <typename T>
+using GemmSmallRun = void (*)(size_t first, size_t last, size_t m, size_t n, size_t k,
+                              const T* a, const T* b, gemm_acc_t<T>* c);
+
+struct GemmSmallKernels {
+  const char* name;
+  GemmSmallRun<double> f64;
+  GemmSmallRun<float> f32;
+  GemmSmallRun<int8_t> i8;
+  GemmSmallRun<int32_t> i32;
+};
+
+// The generic set is built into GemmBatched.cpp with 16-byte vectors.
+extern const GemmSmallKernels gemm_small_generic;
+#ifdef MATRIX_X86_KERNELS
+// Compiled alongside the AVX2 and AVX-512 GEMM kernels; callers check the CPU first.
+extern const GemmSmallKernels gemm_small_avx2;
+extern const GemmSmallKernels gemm_small_avx512;
+#endif
+
+// The kernels are written once with GCC vector extensions and compiled per ISA: V is the
+// vector width in bytes and part of every template, so that each TU keeps its own
+// instantiations instead of the linker merging code built for different -m flags. For the
+// same reason nothing below calls out-of-line library templates at run time.
+template <typename T, size_t N, size_t V>
+struct GemmSmallLayout {
+  using Acc = gemm_acc_t<T>;
+  // Accumulators for a block of C: 16 of the 32 zmm registers, 12 of the 16 ymm/xmm.
+  static constexpr size_t ACC_BYTES = V * (V == 64 ? 16 : 12);
+  // Columns of C per pass and rows per block: wide rows are split into panels so that at
+  // least two rows share every vector of B that is loaded.
+  static constexpr size_t PANEL = std::min(N, std::bit_floor(ACC_BYTES / 2) / sizeof(Acc));
+  static constexpr size_t ROWS = std::bit_floor(std::clamp<size_t>(ACC_BYTES / (PANEL * sizeof(Acc)), 1, 8));
+  static constexpr size_t BYTES = std::min(V, PANEL * sizeof(Acc));
+  static constexpr size_t LANES = BYTES / sizeof(Acc);
+  static constexpr size_t VECTORS = PANEL / LANES;
+
+  typedef Acc AccVec __attribute__((vector_size(BYTES)));
+  typedef T InVec __attribute__((vector_size(LANES * sizeof(T))));
+
+  [[gnu::always_inline]] static AccVec load(const T* p) {
+    InVec v;
+    std::memcpy(&v, p, sizeof(v));
+    if constexpr (std::is_same_v<T, Acc>) {
+      return v;
+    } else {
+      return __builtin_convertvector(v, AccVec);
+    }
+  }
+};
+
+// R rows x PANEL columns of C, accumulated in registers over the whole depth.
+template <typename T, size_t N, size_t K, size_t V, size_t R>
+[[gnu::always_inline]] inline void gemm_small_rows(size_t k, const T* __restrict a, const T* __restrict b,
+                                                   gemm_acc_t<T>* __restrict c) {
+  using L = GemmSmallLayout<T, N, V>;
+  const size_t depth = K != 0 ? K : k;
+
+  typename L::AccVec acc[R][L::VECTORS] = {};
+  for (size_t p = 0; p < depth; ++p) {
+    typename L::AccVec row[L::VECTORS];
+    for (size_t v = 0; v < L::VECTORS; ++v) {
+      row[v] = L::load(b + p * N + v * L::LANES);
+    }
+    for (size_t r = 0; r < R; ++r) {
+      typename L::Acc x = a[r * depth + p];
+      for (size_t v = 0; v < L::VECTORS; ++v) {
+        acc[r][v] += x * row[v];
+      }
+    }
+  }
+  for (size_t r = 0; r < R; ++r) {
+    std::memcpy(c + r * N, acc[r], sizeof(acc[r]));
+  }
+}
+
+// One m x N product; K == 0 means the depth is only known at run time.
+template <typename T, size_t N, size_t K, size_t V>
+[[gnu::always_inline]] inline void gemm_small(size_t m, size_t k, const T* a, const T* b, gemm_acc_t<T>* c) {
+  using L = GemmSmallLayout<T, N, V>;
+  const size_t depth = K != 0 ? K : k;
+
+  for (size_t j = 0; j < N; j += L::PANEL) {
+    size_t i = 0;
+    for (; i + L::ROWS <= m; i += L::ROWS) {
+      gemm_small_rows<T, N, K, V, L::ROWS>(k, a + i * depth, b + j, c + i * N + j);
+    }
+    for (; i < m; ++i) {
+      gemm_small_rows<T, N, K, V, 1>(k, a + i * depth, b + j, c + i * N + j);
+    }
+  }
+}
+
+// Plain loop for row widths without a fixed-size kernel (n <= GEMM_BATCH_MAX_N).
+template <typename T, size_t V>
+[[gnu::always_inline]] inline void gemm_small_any(size_t m, size_t n, size_t k, const T* a, const T* b,
+                                                  gemm_acc_t<T>* c) {
+  using Acc = gemm_acc_t<T>;
+  for (size_t i = 0; i < m; ++i) {
+    Acc row[GEMM_BATCH_MAX_N] = {};
+    for (size_t p = 0; p < k; ++p) {
+      Acc x = a[i * k + p];
+      for (size_t j = 0; j < n; ++j) {
+        row[j] += x * static_cast<Acc>(b[p * n + j]);
+      }
+    }
+    std::memcpy(c + i * n, row, n * sizeof(Acc));
+  }
+}
+
+template <typename T, size_t N, size_t V>
+void gemm_small_fixed(size_t first, size_t last, size_t m, size_t k, const T* a, const T* b, gemm_acc_t<T>* c) {
+  // Square products get the depth fixed as well.
+  if (k == N) {
+    for (size_t i = first; i < last; ++i) {
+      gemm_small<T, N, N, V>(m, k, a + i * m * k, b + i * k * N, c + i * m * N);
+    }
+  } else {
+    for (size_t i = first; i < last; ++i) {
+      gemm_small<T, N, 0, V>(m, k, a + i * m * k, b + i * k * N, c + i * m * N);
+    }
+  }
+}
+
+template <typename T, size_t V>
+void gemm_small_run(size_t first, size_t last, size_t m, size_t n, size_t k, const T* a, const T* b,
+                    gemm_acc_t<T>* c) {
+  switch (n) {
+  case 4:
+    return gemm_small_fixed<T, 4, V>(first, last, m, k, a, b, c);
+  case 8:
+    return gemm_small_fixed<T, 8, V>(first, last, m, k, a, b, c);
+  case 16:
+    return gemm_small_fixed<T, 16, V>(first, last, m, k, a, b, c);
+  case 32:
+    return gemm_small_fixed<T, 32, V>(first, last, m, k, a, b, c);
+  case 64:
+    return gemm_small_fixed<T, 64, V>(first, last, m, k, a, b, c);
+  default:
+    for (size_t i = first; i < last; ++i) {
+      gemm_small_any<T, V>(m, n, k, a + i * m * k, b + i * k * n, c + i * m * n);
+    }
+  }
+}
+
+template <size_t V>
+constexpr GemmSmallKernels make_gemm_small_kernels(const char* name) {
+  return {name, gemm_small_run<double, V>, gemm_small_run<float, V>, gemm_small_run<int8_t, V>,
+          gemm_small_run<int32_t, V>};
+}
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// RAII wrapper over an mmap of a whole file.
+class MappedFile {
+  void* _addr;
+  size_t _length;
+
+public:
+  enum class Mode {
+    ReadOnly,     // PROT_READ, MAP_SHARED: pages come straight from the page cache
+    CopyOnWrite,  // PROT_READ | PROT_WRITE, MAP_PRIVATE: writes stay private to the process
+  };
+
+  enum class Access { Normal, Sequential, Random, WillNeed };
+
+  // populate asks the kernel to fault in every page up front (MAP_POPULATE).
+  MappedFile(const std::string& filename, Mode mode, bool populate = false);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  void advise(Access access) const;
+
+  const char* data() const;
+  char* data();
+  size_t size() const;
+};
+
+#endif
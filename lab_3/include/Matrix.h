@@ -4,38 +4,144 @@
 #include <vector>
 #include <string>
 #include <stdexcept>
+#include <memory>
+#include <cstdint>
+#include <type_traits>
 
+#include "Gemm.h"
+#include "MappedFile.h"
+#include "MatrixAllocator.h"
+#include "MatrixFile.h"
+#include "MatrixView.h"
+
+// Tag for constructors that leave the elements indeterminate, for storage that is about to
+// be overwritten anyway; skipping the zero fill saves a full pass over memory.
+struct uninitialized_t {
+  explicit uninitialized_t() = default;
+};
+inline constexpr uninitialized_t uninitialized{};
+
+// Dense row-major matrix. Instantiated for double (the default), float, int8_t and int32_t;
+// products of int8_t matrices accumulate into Matrix<int32_t>.
+// Storage is 64-byte aligned (2 MiB aligned with MADV_HUGEPAGE for large matrices) and is
+// placed according to numa_placement() (see Numa.h) when it is first written.
+// Element arguments are spelled std::type_identity_t<T> so that `Matrix m(n, 1, 10)`
+// deduces the default double rather than int.
+template <typename E>
+struct MatrixExpr;
+
+template <typename T = double>
 class Matrix {
-  std::vector<double> _data;
-  size_t _size;
+  std::vector<T, MatrixAllocator<T>> _data;
+  size_t _rows;
+  size_t _cols;
+  // Set by open_mapped; _ptr then points into the mapping instead of _data.
+  std::shared_ptr<MappedFile> _mapping;
+  T* _ptr;
 
-  struct ThreadData {
-    const Matrix* mat1;
-    const Matrix* mat2;
-    Matrix* result;
-    size_t start_row;
-    size_t end_row;
-  };
+  template <typename U>
+  friend class Matrix;
 
 public:
+  using value_type = T;
+  using acc_type = gemm_acc_t<T>;
+
   Matrix(size_t n);
-  Matrix(size_t n, double min_value, double max_value);
-  explicit Matrix(const std::vector<double>& matrix);
+  Matrix(size_t rows, size_t cols);
+  // Pages are then placed by whoever writes the elements first rather than by numa_placement().
+  Matrix(size_t n, uninitialized_t);
+  Matrix(size_t rows, size_t cols, uninitialized_t);
+  Matrix(size_t n, std::type_identity_t<T> min_value, std::type_identity_t<T> max_value);
+  Matrix(size_t rows, size_t cols, std::type_identity_t<T> min_value, std::type_identity_t<T> max_value);
+  explicit Matrix(const std::vector<T>& matrix);
+  explicit Matrix(ConstMatrixView<T> view);
+  // Evaluates an element-wise expression in one pass; defined in MatrixExpr.h.
+  template <typename E>
+  Matrix(const MatrixExpr<E>& expr);
 
-  void fill_random(double min_val = 0.0, double max_val = 1.0);
-  void write_to_file(const std::string& filename) const;
+  // Copies always own their storage, even when the source is mapped.
+  Matrix(const Matrix& other);
+  Matrix(Matrix&& other) noexcept;
+  Matrix& operator=(Matrix other) noexcept;
+  // Writes into the existing storage when the shapes match; defined in MatrixExpr.h.
+  template <typename E>
+  Matrix& operator=(const MatrixExpr<E>& expr);
+
+  // Uniform in [min_val, max_val) for floating point, [min_val, max_val] for integers, from
+  // a counter-based generator (see Random.h): the same seed gives the same matrix for any
+  // pool size. Without a seed, the next one from random_next_seed() is used. Large matrices
+  // are filled in parallel, tile by tile, like first-touch placement.
+  void fill_random(std::type_identity_t<T> min_val = T(0), std::type_identity_t<T> max_val = T(1));
+  void fill_random(std::type_identity_t<T> min_val, std::type_identity_t<T> max_val, uint64_t seed);
+  // Writes the versioned format (see MatrixFile.h), by default in T's own dtype;
+  // e.g. Float32 halves a double matrix on disk at reduced precision.
+  void write_to_file(const std::string& filename, DType dtype = dtype_of<T>(), bool with_checksum = false) const;
+  static void write_to_file(const std::string& filename, ConstMatrixView<T> view,
+                            DType dtype = dtype_of<T>(), bool with_checksum = false);
+  // Reads versioned files of any dtype, converting to T, as well as legacy raw square dumps.
   static Matrix read_from_file(const std::string& filename);
+  // Reads a file into an existing window, e.g. one block of a larger matrix; shapes must match.
+  static void read_from_file(const std::string& filename, MatrixView<T> out);
+  // Uses the file's pages as the matrix storage instead of reading it into memory; needs a
+  // file stored as T's dtype and does not verify the checksum, which would touch every page.
+  // ReadOnly maps the pages PROT_READ, so reading works through any accessor but writing
+  // faults; CopyOnWrite takes writes and keeps them private.
+  static Matrix open_mapped(const std::string& filename,
+                            MappedFile::Mode mode = MappedFile::Mode::ReadOnly,
+                            bool populate = false,
+                            MappedFile::Access access = MappedFile::Access::Normal);
   void print() const;
+  // Edge length of a square matrix; same as rows().
   size_t size() const;
+  size_t rows() const;
+  size_t cols() const;
+  bool is_mapped() const;
+
+  // Row-major element storage; must not be written through for ReadOnly mappings.
+  const T* data() const;
+  T* data();
+  ConstMatrixView<T> view() const;
+  MatrixView<T> view();
+  ConstMatrixView<T> block(size_t row, size_t col, size_t rows, size_t cols) const;
+  MatrixView<T> block(size_t row, size_t col, size_t rows, size_t cols);
+
+  T operator()(size_t i, size_t j) const;
+  T& operator()(size_t i, size_t j);
 
-  double operator()(size_t i, size_t j) const;
-  double& operator()(size_t i, size_t j);
+  // (M x K) * (K x N) -> M x N.
+  Matrix<acc_type> multiply(const Matrix& other) const;
+  Matrix<acc_type> multiply_reference(const Matrix& other) const;
+  // Splits the result into 2D tiles computed on ThreadPool::global();
+  // num_threads caps the number of workers used, 0 means the whole pool.
+  Matrix<acc_type> parallel_multiply(const Matrix& other, size_t num_threads = 0) const;
 
-  Matrix multiply(const Matrix& other) const;
-  Matrix parallel_multiply(const Matrix& other, size_t num_threads = 4) const;
+  // In-place forms over views: c = a * b. c must not overlap a or b.
+  static void multiply(ConstMatrixView<T> a, ConstMatrixView<T> b, MatrixView<acc_type> c);
+  static void parallel_multiply(ConstMatrixView<T> a, ConstMatrixView<T> b, MatrixView<acc_type> c,
+                                size_t num_threads = 0);
 
-private:
-  static void* multiply_partial(void* arg);
+  // c = alpha * a * b + beta * c in a single pass over c (see gemm in Gemm.h), tiled over
+  // the pool like parallel_multiply. Not for int8_t, whose products change type.
+  static void gemm(std::type_identity_t<T> alpha, ConstMatrixView<T> a, ConstMatrixView<T> b,
+                   std::type_identity_t<T> beta, MatrixView<T> c, size_t num_threads = 0)
+    requires std::is_same_v<T, acc_type>;
+  // The same with *this as c.
+  Matrix& gemm(std::type_identity_t<T> alpha, const Matrix& a, const Matrix& b,
+               std::type_identity_t<T> beta = T(1), size_t num_threads = 0)
+    requires std::is_same_v<T, acc_type>;
+
+  // Strassen-Winograd product (see gemm_strassen): asymptotically less work for large n, at
+  // some cost in accuracy, so it is opt-in. crossover 0 uses the library default.
+  Matrix strassen_multiply(const Matrix& other, size_t crossover = 0) const
+    requires std::is_floating_point_v<T>;
+  static void strassen_multiply(ConstMatrixView<T> a, ConstMatrixView<T> b, MatrixView<T> c,
+                                size_t crossover = 0)
+    requires std::is_floating_point_v<T>;
 };
 
-#endif
\ No newline at end of file
+extern template class Matrix<double>;
+extern template class Matrix<float>;
+extern template class Matrix<int8_t>;
+extern template class Matrix<int32_t>;
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef MATRIX_ALLOCATOR_H
+#define MATRIX_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "Numa.h"
+
+// std::vector allocator for Matrix storage. Memory comes from numa_allocate, and
+// value-less construction default-initializes instead of zeroing, so vector(n) leaves the
+// pages untouched and Matrix can fault them in from the threads that will use them.
+template <typename T>
+struct MatrixAllocator {
+  using value_type = T;
+
+  MatrixAllocator() = default;
+  template <typename U>
+  MatrixAllocator(const MatrixAllocator<U>&) {}
+
+  T* allocate(size_t count) {
+    return static_cast<T*>(numa_allocate(count * sizeof(T)));
+  }
+
+  void deallocate(T* data, size_t count) {
+    numa_deallocate(data, count * sizeof(T));
+  }
+
+  template <typename U>
+  void construct(U* p) {
+    ::new (static_cast<void*>(p)) U;
+  }
+
+  template <typename U, typename... Args>
+  void construct(U* p, Args&&... args) {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+
+  template <typename U>
+  bool operator==(const MatrixAllocator<U>&) const { return true; }
+};
+
+#endif
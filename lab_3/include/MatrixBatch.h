@@ -0,0 +1,62 @@
+#ifndef MATRIX_BATCH_H
+#define MATRIX_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "Gemm.h"
+#include "Matrix.h"
+#include "MatrixAllocator.h"
+#include "MatrixView.h"
+
+// count same-sized row-major matrices stored back to back, for workloads made of many small
+// products (8x8 .. 64x64) where a Matrix per item would cost an allocation, bounds checks and
+// a pool job each. Items are views into the one buffer; multiply() runs the whole batch in
+// one gemm_batched call, parallel across items.
+template <typename T = double>
+class MatrixBatch {
+  std::vector<T, MatrixAllocator<T>> _data;
+  size_t _count;
+  size_t _rows;
+  size_t _cols;
+
+public:
+  using value_type = T;
+  using acc_type = gemm_acc_t<T>;
+
+  // Zero-filled.
+  MatrixBatch(size_t count, size_t rows, size_t cols);
+  MatrixBatch(size_t count, size_t rows, size_t cols, uninitialized_t);
+
+  size_t count() const { return _count; }
+  size_t rows() const { return _rows; }
+  size_t cols() const { return _cols; }
+
+  // Item i starts at data() + i * rows() * cols().
+  const T* data() const { return _data.data(); }
+  T* data() { return _data.data(); }
+
+  // Unchecked, like std::vector::operator[].
+  ConstMatrixView<T> operator[](size_t i) const {
+    return ConstMatrixView<T>(data() + i * _rows * _cols, _rows, _cols);
+  }
+  MatrixView<T> operator[](size_t i) {
+    return MatrixView<T>(data() + i * _rows * _cols, _rows, _cols);
+  }
+
+  // Same distribution and seeding as Matrix::fill_random, over the batch as one stream.
+  void fill_random(std::type_identity_t<T> min_val = T(0), std::type_identity_t<T> max_val = T(1));
+  void fill_random(std::type_identity_t<T> min_val, std::type_identity_t<T> max_val, uint64_t seed);
+
+  // Item-wise products: result[i] = (*this)[i] * other[i].
+  MatrixBatch<acc_type> multiply(const MatrixBatch& other, size_t num_threads = 0) const;
+};
+
+extern template class MatrixBatch<double>;
+extern template class MatrixBatch<float>;
+extern template class MatrixBatch<int8_t>;
+extern template class MatrixBatch<int32_t>;
+
+#endif
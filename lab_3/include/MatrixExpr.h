@@ -0,0 +1,299 @@
+#ifndef MATRIX_EXPR_H
+#define MATRIX_EXPR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "Matrix.h"
+#include "MatrixTiling.h"
+#include "MatrixView.h"
+
+// Lazy element-wise arithmetic on matrices and views. Operators only build a small
+// expression object; the elements are computed when it is assigned, in a single pass over
+// the destination with no temporaries in between:
+//   Matrix<> d = 2.0 * a + transpose(b) - c;      // one sweep over d
+//   c += 0.5 * a;                                   // in place, c read and written once
+//   assign(c.block(0, 0, 64, 64), -a.block(0, 0, 64, 64));
+// Operands are Matrix, views or other expressions; shapes are checked when the expression
+// is built. Products are not element-wise: use Matrix::gemm for c = alpha * a * b + beta * c.
+
+template <typename E>
+struct MatrixExpr {
+  const E& self() const { return static_cast<const E&>(*this); }
+};
+
+// Leaf reading a strided view. Nodes hold their operands by value (views are three
+// words), so an expression stays valid as long as the matrices it reads do.
+template <typename T>
+class ViewExpr : public MatrixExpr<ViewExpr<T>> {
+  ConstMatrixView<T> _view;
+
+public:
+  using value_type = T;
+  static constexpr bool transposes = false;
+
+  explicit ViewExpr(ConstMatrixView<T> view) : _view(view) {}
+
+  size_t rows() const { return _view.rows(); }
+  size_t cols() const { return _view.cols(); }
+  T operator()(size_t i, size_t j) const { return _view.data()[i * _view.ld() + j]; }
+
+  // Whether writing element (i, j) of the rows x cols window at dst (stride ld) can happen
+  // while this expression is still being read: either the storage does not overlap, or
+  // (i, j) of the destination is exactly what this leaf reads at (i, j) and nothing else.
+  template <typename U>
+  bool can_write(const U* dst, size_t rows, size_t cols, size_t ld, bool transposed) const {
+    if (_view.rows() == 0 || _view.cols() == 0 || rows == 0 || cols == 0) {
+      return true;
+    }
+    auto first = reinterpret_cast<std::uintptr_t>(_view.data());
+    auto last = reinterpret_cast<std::uintptr_t>(_view.data() + (_view.rows() - 1) * _view.ld() + _view.cols());
+    auto dst_first = reinterpret_cast<std::uintptr_t>(dst);
+    auto dst_last = reinterpret_cast<std::uintptr_t>(dst + (rows - 1) * ld + cols);
+    if (last <= dst_first || dst_last <= first) {
+      return true;
+    }
+    return std::is_same_v<T, U> && !transposed && first == dst_first && _view.ld() == ld;
+  }
+};
+
+template <typename L, typename R, typename Op>
+class BinaryExpr : public MatrixExpr<BinaryExpr<L, R, Op>> {
+  L _left;
+  R _right;
+
+public:
+  using value_type = std::common_type_t<typename L::value_type, typename R::value_type>;
+  static constexpr bool transposes = L::transposes || R::transposes;
+
+  BinaryExpr(L left, R right) : _left(std::move(left)), _right(std::move(right)) {
+    if (_left.rows() != _right.rows() || _left.cols() != _right.cols()) {
+      throw std::invalid_argument("Matrix dimensions must agree for element-wise operation");
+    }
+  }
+
+  size_t rows() const { return _left.rows(); }
+  size_t cols() const { return _left.cols(); }
+  value_type operator()(size_t i, size_t j) const {
+    return static_cast<value_type>(Op{}(static_cast<value_type>(_left(i, j)), static_cast<value_type>(_right(i, j))));
+  }
+
+  template <typename U>
+  bool can_write(const U* dst, size_t rows, size_t cols, size_t ld, bool transposed) const {
+    return _left.can_write(dst, rows, cols, ld, transposed) && _right.can_write(dst, rows, cols, ld, transposed);
+  }
+};
+
+// Floating-point matrices keep their element type (2.0 * a stays float for float a); integer
+// matrices scaled by a fraction are promoted rather than have the scale truncated.
+template <typename E, typename S>
+class ScaleExpr : public MatrixExpr<ScaleExpr<E, S>> {
+  E _expr;
+  S _scale;
+
+public:
+  using value_type = std::conditional_t<std::is_floating_point_v<typename E::value_type>,
+                                        typename E::value_type,
+                                        std::common_type_t<typename E::value_type, S>>;
+  static constexpr bool transposes = E::transposes;
+
+  ScaleExpr(E expr, S scale) : _expr(std::move(expr)), _scale(scale) {}
+
+  size_t rows() const { return _expr.rows(); }
+  size_t cols() const { return _expr.cols(); }
+  value_type operator()(size_t i, size_t j) const {
+    return static_cast<value_type>(static_cast<value_type>(_scale) * static_cast<value_type>(_expr(i, j)));
+  }
+
+  template <typename U>
+  bool can_write(const U* dst, size_t rows, size_t cols, size_t ld, bool transposed) const {
+    return _expr.can_write(dst, rows, cols, ld, transposed);
+  }
+};
+
+template <typename E>
+class TransposeExpr : public MatrixExpr<TransposeExpr<E>> {
+  E _expr;
+
+public:
+  using value_type = typename E::value_type;
+  static constexpr bool transposes = true;
+
+  explicit TransposeExpr(E expr) : _expr(std::move(expr)) {}
+
+  size_t rows() const { return _expr.cols(); }
+  size_t cols() const { return _expr.rows(); }
+  value_type operator()(size_t i, size_t j) const { return _expr(j, i); }
+
+  // Any overlap is unsafe under a transpose, except that a transpose of a transpose reads
+  // in place again.
+  template <typename U>
+  bool can_write(const U* dst, size_t rows, size_t cols, size_t ld, bool transposed) const {
+    return _expr.can_write(dst, rows, cols, ld, !transposed);
+  }
+};
+
+// Anything that can appear in an expression, wrapped as a node.
+template <typename T>
+ViewExpr<T> as_expr(const Matrix<T>& matrix) {
+  return ViewExpr<T>(matrix.view());
+}
+
+template <typename T>
+ViewExpr<std::remove_const_t<T>> as_expr(BasicMatrixView<T> view) {
+  return ViewExpr<std::remove_const_t<T>>(view);
+}
+
+template <typename E>
+const E& as_expr(const MatrixExpr<E>& expr) {
+  return expr.self();
+}
+
+template <typename X>
+concept MatrixOperand = requires(const X& x) { as_expr(x); };
+
+template <typename X>
+using expr_t = std::decay_t<decltype(as_expr(std::declval<const X&>()))>;
+
+template <MatrixOperand L, MatrixOperand R>
+auto operator+(const L& left, const R& right) {
+  return BinaryExpr<expr_t<L>, expr_t<R>, std::plus<>>(as_expr(left), as_expr(right));
+}
+
+template <MatrixOperand L, MatrixOperand R>
+auto operator-(const L& left, const R& right) {
+  return BinaryExpr<expr_t<L>, expr_t<R>, std::minus<>>(as_expr(left), as_expr(right));
+}
+
+// Element-wise (Hadamard) product; operator* between matrices is deliberately absent.
+template <MatrixOperand L, MatrixOperand R>
+auto hadamard(const L& left, const R& right) {
+  return BinaryExpr<expr_t<L>, expr_t<R>, std::multiplies<>>(as_expr(left), as_expr(right));
+}
+
+template <MatrixOperand X, typename S>
+  requires std::is_arithmetic_v<S>
+auto operator*(const X& x, S scale) {
+  return ScaleExpr<expr_t<X>, S>(as_expr(x), scale);
+}
+
+template <MatrixOperand X, typename S>
+  requires std::is_arithmetic_v<S>
+auto operator*(S scale, const X& x) {
+  return ScaleExpr<expr_t<X>, S>(as_expr(x), scale);
+}
+
+template <MatrixOperand X>
+auto operator-(const X& x) {
+  using T = typename expr_t<X>::value_type;
+  return ScaleExpr<expr_t<X>, T>(as_expr(x), T(-1));
+}
+
+template <MatrixOperand X>
+auto transpose(const X& x) {
+  return TransposeExpr<expr_t<X>>(as_expr(x));
+}
+
+namespace matrix_expr_detail {
+
+// Square blocks for expressions that read across rows, so the transposed side still
+// uses every cache line it loads; 32 doubles are four lines.
+constexpr size_t TRANSPOSE_BLOCK = 32;
+
+template <typename T, typename E>
+void evaluate_tile(MatrixView<T> dst, const E& expr, size_t row, size_t col, size_t rows, size_t cols) {
+  size_t step = E::transposes ? TRANSPOSE_BLOCK : cols;
+  for (size_t jb = col; jb < col + cols; jb += step) {
+    size_t je = std::min(jb + step, col + cols);
+    for (size_t i = row; i < row + rows; ++i) {
+      T* out = dst.data() + i * dst.ld();
+      for (size_t j = jb; j < je; ++j) {
+        out[j] = static_cast<T>(expr(i, j));
+      }
+    }
+  }
+}
+
+template <typename T, typename E>
+void evaluate(MatrixView<T> dst, const E& expr) {
+  auto tile = [&](size_t row, size_t col, size_t rows, size_t cols) {
+    if constexpr (E::transposes) {
+      for (size_t ib = row; ib < row + rows; ib += TRANSPOSE_BLOCK) {
+        evaluate_tile(dst, expr, ib, col, std::min(TRANSPOSE_BLOCK, row + rows - ib), cols);
+      }
+    } else {
+      evaluate_tile(dst, expr, row, col, rows, cols);
+    }
+  };
+
+  if (matrix_touch_in_parallel(dst.rows() * dst.cols() * sizeof(T))) {
+    matrix_for_each_tile(dst.rows(), dst.cols(), ThreadPool::global().size(), tile);
+  } else {
+    tile(0, 0, dst.rows(), dst.cols());
+  }
+}
+
+}
+
+// dst = expr, element by element. When dst overlaps an operand in a way a single pass
+// cannot handle (e.g. a = transpose(a)), the result goes through a temporary first.
+template <typename T, typename E>
+void assign(MatrixView<T> dst, const MatrixExpr<E>& expr) {
+  const E& e = expr.self();
+  if (dst.rows() != e.rows() || dst.cols() != e.cols()) {
+    throw std::invalid_argument("Matrix dimensions must agree for assignment");
+  }
+  if (e.can_write(dst.data(), dst.rows(), dst.cols(), dst.ld(), false)) {
+    matrix_expr_detail::evaluate(dst, e);
+  } else {
+    Matrix<T> result(e.rows(), e.cols(), uninitialized);
+    matrix_expr_detail::evaluate(result.view(), e);
+    matrix_expr_detail::evaluate(dst, as_expr(result));
+  }
+}
+
+template <typename E>
+Matrix(const MatrixExpr<E>&) -> Matrix<typename E::value_type>;
+
+template <typename T>
+template <typename E>
+Matrix<T>::Matrix(const MatrixExpr<E>& expr) : Matrix(expr.self().rows(), expr.self().cols(), uninitialized) {
+  matrix_expr_detail::evaluate(view(), expr.self());
+}
+
+template <typename T>
+template <typename E>
+Matrix<T>& Matrix<T>::operator=(const MatrixExpr<E>& expr) {
+  if (_rows == expr.self().rows() && _cols == expr.self().cols()) {
+    assign(view(), expr);
+  } else {
+    *this = Matrix(expr);
+  }
+  return *this;
+}
+
+template <typename T, MatrixOperand X>
+Matrix<T>& operator+=(Matrix<T>& matrix, const X& x) {
+  assign(matrix.view(), as_expr(matrix) + x);
+  return matrix;
+}
+
+template <typename T, MatrixOperand X>
+Matrix<T>& operator-=(Matrix<T>& matrix, const X& x) {
+  assign(matrix.view(), as_expr(matrix) - x);
+  return matrix;
+}
+
+template <typename T, typename S>
+  requires std::is_arithmetic_v<S>
+Matrix<T>& operator*=(Matrix<T>& matrix, S scale) {
+  assign(matrix.view(), as_expr(matrix) * scale);
+  return matrix;
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// On-disk matrix format, version 1:
+//   [0, 64)              MatrixFileHeader, little-endian on every host we build for
+//   [64, payload_offset) zero padding so the payload starts on a page boundary for mmap
+//   [payload_offset, ..) rows * cols elements of dtype, row-major
+// Files without the magic are legacy raw dumps: a square matrix of doubles and nothing else.
+
+enum class DType : uint32_t {
+  Float64 = 1,
+  Float32 = 2,
+  Int8 = 3,
+  Int32 = 4,
+};
+
+size_t dtype_size(DType dtype);
+
+// The dtype a Matrix<T> is stored as by default.
+template <typename T>
+constexpr DType dtype_of();
+template <> constexpr DType dtype_of<double>() { return DType::Float64; }
+template <> constexpr DType dtype_of<float>() { return DType::Float32; }
+template <> constexpr DType dtype_of<int8_t>() { return DType::Int8; }
+template <> constexpr DType dtype_of<int32_t>() { return DType::Int32; }
+
+constexpr size_t MATRIX_FILE_ALIGNMENT = 4096;
+
+struct MatrixFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;  // 0x01020304 as stored by the writer
+  uint64_t rows;
+  uint64_t cols;
+  uint32_t dtype;
+  uint32_t flags;
+  uint64_t payload_offset;
+  uint32_t checksum;    // CRC-32 of the payload when MATRIX_FILE_CHECKSUM is set
+  uint32_t reserved[3];
+};
+static_assert(sizeof(MatrixFileHeader) == 64, "Matrix file header must stay 64 bytes");
+
+constexpr uint32_t MATRIX_FILE_CHECKSUM = 1;
+
+struct MatrixFileInfo {
+  size_t rows;
+  size_t cols;
+  DType dtype;
+  size_t payload_offset;
+  bool legacy;
+  bool has_checksum;
+  uint32_t checksum;
+};
+
+// Describes a file of file_size bytes given its first `available` bytes. Throws
+// std::runtime_error if the header is malformed, the payload is not aligned to
+// MATRIX_FILE_ALIGNMENT or the size does not match.
+MatrixFileInfo parse_matrix_header(const char* data, size_t available, size_t file_size);
+
+// Reads and parses the header of an open file.
+MatrixFileInfo read_matrix_header(int fd);
+
+// Writes a versioned file, converting the elements to dtype on the way out.
+// Row i of the matrix starts at values + i * ld. Instantiated for the Matrix element types.
+template <typename T>
+void write_matrix_file(const std::string& filename, size_t rows, size_t cols, const T* values,
+                       size_t ld, DType dtype, bool with_checksum);
+
+// Reads the payload described by info into out (row i at out + i * ld), converting from
+// the stored dtype and verifying the checksum when one is present.
+template <typename T>
+void read_matrix_payload(int fd, const MatrixFileInfo& info, T* out, size_t ld);
+
+// Block access for data that does not fit in memory. Row i of the rows x cols block at
+// (row, col) is at values/out + i * ld; elements are converted to or from the stored dtype.
+// Checksums cover the whole payload, so they are neither verified nor maintained here.
+template <typename T>
+void read_matrix_block(int fd, const MatrixFileInfo& info, size_t row, size_t col, size_t rows, size_t cols,
+                       T* out, size_t ld);
+template <typename T>
+void write_matrix_block(int fd, const MatrixFileInfo& info, size_t row, size_t col, size_t rows, size_t cols,
+                        const T* values, size_t ld);
+
+// Writes the header of a rows x cols file of dtype to an open, writable file and sizes it;
+// the payload reads as zeros until write_matrix_block fills it in.
+MatrixFileInfo create_matrix_file(int fd, size_t rows, size_t cols, DType dtype);
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
+
+#endif
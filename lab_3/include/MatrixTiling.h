@@ -0,0 +1,50 @@
+#ifndef MATRIX_TILING_H
+#define MATRIX_TILING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "Numa.h"
+#include "ThreadPool.h"
+
+// How Matrix spreads per-element work over ThreadPool::global(): products, first-touch
+// placement, random fills and expression evaluation all cut their output the same way.
+
+// Edge of the square output tiles handed to the pool: about four tiles per worker so that
+// uneven sizes still balance, but never so small that re-packing A and B dominates.
+inline size_t matrix_tile_size(size_t rows, size_t cols, size_t workers) {
+  constexpr size_t MIN_TILE = 32;
+  constexpr size_t MAX_TILE = 512;
+  double area = static_cast<double>(rows) * static_cast<double>(cols) / (4.0 * workers);
+  size_t tile = std::clamp(static_cast<size_t>(std::sqrt(area)), MIN_TILE, MAX_TILE);
+  return (tile + 15) / 16 * 16;
+}
+
+// Runs fn(row, col, rows, cols) for every output tile on the pool. Participants start on
+// contiguous runs of tiles, but idle ones steal, and participant 0 is the calling thread,
+// which is not pinned; so the same tile only tends to land on the same thread when the
+// grid (shape and worker count) repeats and the load is even. That is all first-touch
+// placement gets: locality in the common case, not a guarantee. It tiles for the whole
+// pool, which only matches products run with the default num_threads.
+template <typename Fn>
+void matrix_for_each_tile(size_t rows, size_t cols, size_t workers, Fn fn) {
+  size_t tile = matrix_tile_size(rows, cols, workers);
+  size_t tile_rows = (rows + tile - 1) / tile;
+  size_t tile_cols = (cols + tile - 1) / tile;
+
+  ThreadPool::global().parallel_for(tile_rows * tile_cols, [&](size_t t) {
+    size_t row = (t / tile_cols) * tile;
+    size_t col = (t % tile_cols) * tile;
+    fn(row, col, std::min(tile, rows - row), std::min(tile, cols - col));
+  }, workers);
+}
+
+// Whether writing a fresh matrix of this size is spread over the pool. Small matrices are
+// not worth a job, and NumaPlacement::Serial keeps every first write on the calling thread.
+inline bool matrix_touch_in_parallel(size_t bytes) {
+  return bytes >= NUMA_MIN_BYTES && numa_placement() != NumaPlacement::Serial &&
+         ThreadPool::global().size() > 1 && !ThreadPool::in_task();
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef MATRIX_VIEW_H
+#define MATRIX_VIEW_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+
+// Non-owning row-major window over someone else's storage: element (i, j) lives at
+// data[i * ld + j], so a view can describe a row panel, a column block or any
+// sub-block of a larger matrix without copying it. T is const for read-only views.
+template <typename T>
+class BasicMatrixView {
+  T* _data;
+  size_t _rows;
+  size_t _cols;
+  size_t _ld;
+
+public:
+  BasicMatrixView(T* data, size_t rows, size_t cols, size_t ld)
+      : _data(data), _rows(rows), _cols(cols), _ld(ld) {
+    if (ld < cols) {
+      throw std::invalid_argument("Leading dimension must be at least the number of columns");
+    }
+  }
+
+  BasicMatrixView(T* data, size_t rows, size_t cols) : BasicMatrixView(data, rows, cols, cols) {}
+
+  // A mutable view converts to a read-only one.
+  template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+  BasicMatrixView(const BasicMatrixView<U>& other)
+      : _data(other.data()), _rows(other.rows()), _cols(other.cols()), _ld(other.ld()) {}
+
+  T* data() const { return _data; }
+  size_t rows() const { return _rows; }
+  size_t cols() const { return _cols; }
+  size_t ld() const { return _ld; }
+  bool contiguous() const { return _ld == _cols || _rows <= 1; }
+
+  T& operator()(size_t i, size_t j) const {
+    if (i >= _rows || j >= _cols) {
+      throw std::out_of_range("Matrix view indices out of range");
+    }
+    return _data[i * _ld + j];
+  }
+
+  BasicMatrixView block(size_t row, size_t col, size_t rows, size_t cols) const {
+    if (row > _rows || col > _cols || rows > _rows - row || cols > _cols - col) {
+      throw std::out_of_range("Matrix view block out of range");
+    }
+    return BasicMatrixView(_data + row * _ld + col, rows, cols, _ld);
+  }
+};
+
+template <typename T>
+using MatrixView = BasicMatrixView<T>;
+template <typename T>
+using ConstMatrixView = BasicMatrixView<const T>;
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include <vector>
+
+// Where the pages of newly allocated Matrix storage end up on multi-socket machines.
+enum class NumaPlacement {
+  Serial,      // the constructing thread touches every page, so all of them land on its node
+  FirstTouch,  // pool workers touch the tiles they will later compute in parallel_multiply
+  Interleave,  // pages are spread round-robin over all nodes (MPOL_INTERLEAVE)
+};
+
+// Applies to allocations made after the call. The initial choice is FirstTouch, or
+// MATRIX_NUMA=serial|first-touch|interleave.
+void numa_set_placement(NumaPlacement placement);
+NumaPlacement numa_placement();
+const char* numa_placement_name(NumaPlacement placement);
+
+// Number of online memory nodes; 1 on non-NUMA machines.
+size_t numa_node_count();
+
+// Node holding the page at addr, faulting it in if needed; -1 if the kernel cannot say.
+int numa_node_of(const void* addr);
+
+// Pages per node over [data, data + bytes), sampling every stride-th page.
+std::vector<size_t> numa_page_histogram(const void* data, size_t bytes, size_t stride = 1);
+
+// Raw storage for Matrix. Small blocks come from the heap, 64-byte aligned for SIMD loads.
+// From NUMA_MIN_BYTES up a block gets its own mapping, with the interleave policy applied
+// when selected; from 2 MiB up that mapping is also 2 MiB aligned and marked MADV_HUGEPAGE.
+// Nothing is touched here, so placement is decided by whoever writes the memory first.
+constexpr size_t NUMA_MIN_BYTES = 1 << 20;
+void* numa_allocate(size_t bytes);
+void numa_deallocate(void* data, size_t bytes);
+
+#endif
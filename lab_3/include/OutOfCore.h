@@ -0,0 +1,37 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include <cstddef>
+#include <string>
+
+// Products of matrix files (see MatrixFile.h) that do not fit in memory. C is computed one
+// block at a time from a row panel of A and a column panel of B, each product running on
+// the pool with the blocked kernels, while a background I/O thread reads the next panels
+// and writes finished blocks of C, so I/O overlaps compute. A is read once; B once per row
+// panel of A, which is why A gets the larger share of the budget.
+struct OutOfCoreOptions {
+  // Upper bound on the bytes of A, B and C held in memory, double buffers included.
+  size_t memory_budget = size_t(1) << 30;
+  // Workers for each block product; 0 means the whole pool.
+  size_t num_threads = 0;
+};
+
+struct OutOfCoreStats {
+  size_t panel_rows;       // rows of A and C per panel
+  size_t panel_cols;       // columns of B and C per panel
+  size_t bytes_read;
+  size_t bytes_written;
+  double compute_seconds;
+  double io_wait_seconds;  // time compute stood still waiting for the I/O thread
+};
+
+// c_file = a_file * b_file with T elements in memory; the inputs may be stored as any dtype,
+// and C is written as dtype_of<gemm_acc_t<T>>() without a checksum. Throws
+// std::invalid_argument if the shapes disagree, c_file is one of the inputs or the budget
+// cannot hold a single row and column panel, std::runtime_error on I/O errors. Instantiated
+// for the Matrix element types.
+template <typename T = double>
+OutOfCoreStats multiply_out_of_core(const std::string& a_file, const std::string& b_file,
+                                    const std::string& c_file, const OutOfCoreOptions& options = {});
+
+#endif
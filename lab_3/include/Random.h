@@ -0,0 +1,26 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Counter-based generation: element i of a fill seeded with s is a pure function of (s, i),
+// so a matrix comes out the same whichever threads produce which parts of it.
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"). Writes the
+// two 64-bit halves of blocks first .. first + count - 1 under key to out[0 .. 2 * count).
+// Lanes are independent, so the round loops vectorize.
+void philox4x32(uint64_t key, uint64_t first, size_t count, uint64_t* out);
+
+// out[j] = element first + j of the uniform stream for seed: [min, max) for floating point,
+// [min, max] for integers. Instantiated for the Matrix element types.
+template <typename T>
+void random_uniform(uint64_t seed, size_t first, size_t count, T min, T max, T* out);
+
+// Seeds handed out by random_next_seed() derive from this one; set it for reproducible runs.
+// Initially MATRIX_SEED, or a random value if unset.
+void random_set_seed(uint64_t seed);
+// Fresh seed for the next fill, so consecutive fills differ but the sequence is reproducible.
+uint64_t random_next_seed();
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What a scan selects: one value, an inclusive range, or any of a small set of values.
+struct SearchPredicate {
+  enum class Kind { Equal, Range, AnyOf };
+
+  Kind kind;
+  int32_t low;                   // Equal: the target; Range: the lower bound
+  int32_t high;                  // Range: the upper bound (inclusive)
+  std::vector<int32_t> targets;  // AnyOf
+
+  static SearchPredicate equal(int32_t target);
+  static SearchPredicate range(int32_t low, int32_t high);
+  static SearchPredicate any_of(std::vector<int32_t> targets);
+
+  bool matches(int32_t value) const;
+};
+
+// Elements per scan task. Tasks are balanced over ThreadPool::global() by work stealing,
+// and within a task the comparisons run in the widest SIMD kernel the CPU supports (the
+// ISA follows gemm_set_isa / MATRIX_ISA like the GEMM kernels).
+constexpr size_t SEARCH_CHUNK = 1 << 16;
+
+// Number of matches, without materializing any index. num_threads caps the workers used,
+// 0 means the whole pool.
+size_t search_count(const int32_t* data, size_t size, const SearchPredicate& predicate, size_t num_threads = 0);
+
+// Indices of all matches in ascending order. Each chunk collects its matches in a buffer of
+// its own, so the scan shares nothing between threads; the buffers are concatenated at the end.
+std::vector<size_t> search_find(const int32_t* data, size_t size, const SearchPredicate& predicate,
+                                size_t num_threads = 0);
+
+// Many Equal queries answered in one pass, so the array is read once rather than once per
+// target: each element is looked up in a table of the targets (a direct table when they span
+// at most SEARCH_TABLE_SPAN values, a hash table otherwise), and runs of 16 elements outside
+// [min target, max target] are skipped with one vectorized compare. Results are per target,
+// in the order given; duplicate targets get the same result.
+constexpr size_t SEARCH_TABLE_SPAN = 1 << 16;
+
+std::vector<size_t> search_count_many(const int32_t* data, size_t size, const std::vector<int32_t>& targets,
+                                      size_t num_threads = 0);
+std::vector<std::vector<size_t>> search_find_many(const int32_t* data, size_t size,
+                                                  const std::vector<int32_t>& targets, size_t num_threads = 0);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SEARCH_KERNELS_H
+#define SEARCH_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Search.h"
+
+// SearchPredicate flattened for the kernels, which live in TUs built with different -m flags
+// and so stay away from std::vector and other shared inline code.
+struct SearchKernelArgs {
+  SearchPredicate::Kind kind;
+  int32_t low;
+  int32_t high;
+  const int32_t* targets;
+  size_t target_count;
+};
+
+// Scan kernels over n <= SEARCH_CHUNK elements: count returns the number of matches, find
+// also writes their offsets from data, ascending, to out (room for n) and returns how many.
+struct SearchKernels {
+  const char* name;
+  size_t (*count)(const int32_t* data, size_t n, const SearchKernelArgs& args);
+  size_t (*find)(const int32_t* data, size_t n, const SearchKernelArgs& args, uint32_t* out);
+};
+
+#ifdef MATRIX_X86_KERNELS
+// Built with -mavx2 and -mavx512f respectively; only call after a CPUID check.
+extern const SearchKernels search_kernels_avx2;
+extern const SearchKernels search_kernels_avx512;
+#endif
+
+#endif
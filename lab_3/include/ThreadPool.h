@@ -0,0 +1,100 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <vector>
+#include <pthread.h>
+
+#include "WorkDeque.h"
+
+// Fixed set of pthread workers that Matrix operations submit index-space jobs to.
+// The calling thread takes part in every job, so a pool of size N spawns N - 1 threads.
+// Each job's indices are split into contiguous blocks, one per participant's WorkDeque;
+// a participant that drains its own block steals from the others.
+// With pinning, worker i is bound to the (i + 1)-th CPU of the creating thread's affinity
+// mask, wrapping around, so tiles keep running where their pages were first touched.
+class ThreadPool {
+public:
+  // Per-participant counters; slot 0 is the submitting thread, slot i the i-th worker.
+  // Idle time is the part of each job's wall time the participant spent not running tasks.
+  struct WorkerStats {
+    uint64_t tasks;
+    uint64_t steals;
+    uint64_t failed_steals;
+    double busy_seconds;
+    double idle_seconds;
+  };
+
+private:
+  struct Job {
+    const std::function<void(size_t)>* task;
+    std::vector<uint64_t> busy_ns;
+    size_t active;
+    std::exception_ptr error;
+  };
+
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> tasks{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> failed_steals{0};
+    std::atomic<uint64_t> busy_ns{0};
+    std::atomic<uint64_t> idle_ns{0};
+  };
+
+  std::vector<pthread_t> _threads;
+  pthread_mutex_t _submit_mutex;
+  mutable pthread_mutex_t _mutex;
+  pthread_cond_t _work_ready;
+  pthread_cond_t _work_done;
+  Job* _job;
+  size_t _participants;
+  size_t _generation;
+  bool _stop;
+  bool _pinned;
+
+  struct WorkerArgs {
+    ThreadPool* pool;
+    size_t index;
+  };
+  std::vector<WorkerArgs> _worker_args;
+  std::vector<WorkDeque> _deques;
+  std::vector<Counters> _counters;
+
+public:
+  explicit ThreadPool(size_t num_threads, bool pin_threads = false);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t size() const;
+  bool pinned() const;
+
+  std::vector<WorkerStats> stats() const;
+  void reset_stats();
+
+  // Runs task(0) .. task(count - 1) on at most max_workers threads and waits for all of them.
+  // The first exception thrown by a task is rethrown here. Calls made from inside a pool
+  // task run inline on the calling worker.
+  void parallel_for(size_t count, const std::function<void(size_t)>& task, size_t max_workers = SIZE_MAX);
+
+  // Library-wide pool, started on first use. Its size defaults to MATRIX_NUM_THREADS or,
+  // if unset, the number of CPUs in the process affinity mask; MATRIX_PIN_THREADS=1 pins it.
+  static ThreadPool& global();
+  // Replaces the global pool with one of num_threads workers; must not race with running jobs.
+  // The first form keeps the MATRIX_PIN_THREADS choice.
+  static void set_global_size(size_t num_threads);
+  static void set_global_size(size_t num_threads, bool pin_threads);
+  // True while the calling thread is running a pool task, i.e. when parallel_for would run inline.
+  static bool in_task();
+
+private:
+  static void* worker_main(void* arg);
+  void run(Job& job, size_t self);
+};
+
+#endif
@@ -0,0 +1,815 @@
+#ifndef THREAD_SAFE_QUEUE_H
+#define THREAD_SAFE_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <queue>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "check.hpp"
+
+// Bounded blocking queues with one interface:
+//   enqueue(v), emplace(args...)
+//                    block while the queue is full; false, with the element dropped, once
+//                    set_done() was called. enqueue(T&&) moves, so move-only types work
+//   dequeue()        blocks while the queue is empty; std::nullopt once done and drained,
+//                    so every T, zero included, is an ordinary element
+//   enqueue_for(v, timeout), dequeue_for(out, timeout)
+//                    block for at most timeout and say why they returned: Ok, Timeout, or
+//                    Closed once done (and, for dequeue, drained). v is consumed and out
+//                    assigned only on Ok
+//   try_enqueue(v), try_emplace(args...)
+//                    false instead of blocking
+//   try_dequeue()    std::nullopt instead of blocking
+//   enqueue_bulk(items)
+//                    moves every item in, blocking for space; fewer only once done
+//   dequeue_bulk(out, max)
+//                    blocks for at least one element, then moves up to min(max, out.size())
+//                    out; 0 once done and drained
+//   try_enqueue_bulk / try_dequeue_bulk
+//                    as many as possible without blocking
+//   full(), empty()  snapshots
+//   set_done()       wakes every blocked caller
+// The bulk forms move many elements per synchronization: one lock round trip and one
+// wake-up for the mutex queue, one claim of the ring position for the ring queues.
+// A caller that cannot proceed waits as the queue's QueueWait says, given to the
+// constructor after the capacity: spin briefly, then sleep on a futex. Sleepers are
+// counted and the wake-up is skipped while nobody sleeps, so a queue that never runs full
+// or empty makes no system calls at all.
+// ThreadSafeQueue<T, Policy> picks the implementation, see queue_policy below.
+
+// Why a timed operation returned.
+enum class QueueStatus { Ok, Timeout, Closed };
+
+namespace queue_detail {
+
+// The CLOCK_MONOTONIC time timeout from now; negative timeouts mean now.
+template <typename Rep, typename Period>
+timespec deadline_after(const std::chrono::duration<Rep, Period>& timeout) {
+  using std::chrono::nanoseconds;
+  constexpr auto max_timeout = std::chrono::hours(24 * 365 * 100);
+  nanoseconds wait = timeout <= timeout.zero() ? nanoseconds(0)
+                     : timeout >= max_timeout  ? nanoseconds(max_timeout)
+                                               : std::chrono::ceil<nanoseconds>(timeout);
+  timespec deadline;
+  check(clock_gettime(CLOCK_MONOTONIC, &deadline));
+  long long ns = deadline.tv_nsec + wait.count() % 1000000000;
+  deadline.tv_sec += static_cast<time_t>(wait.count() / 1000000000 + ns / 1000000000);
+  deadline.tv_nsec = static_cast<long>(ns % 1000000000);
+  return deadline;
+}
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "futex words are plain 32-bit integers");
+
+// Sleeps while word still holds expected, until a futex_wake on it or the CLOCK_MONOTONIC
+// deadline (none: no limit). Returns false once the deadline has passed; other returns may
+// be spurious, so the caller re-checks its condition.
+inline bool futex_wait(std::atomic<uint32_t>& word, uint32_t expected, const timespec* deadline) {
+  long result = syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG,
+                        expected, deadline, nullptr, FUTEX_BITSET_MATCH_ANY);
+  return check_except(result, EAGAIN, EINTR, ETIMEDOUT) == 0 || errno != ETIMEDOUT;
+}
+
+inline void futex_wake(std::atomic<uint32_t>& word, int count) {
+  check(syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE | FUTEX_PRIVATE_FLAG, count, nullptr,
+                nullptr, 0));
+}
+
+// Tells the core this is a spin-wait: saves power and, on x86, avoids the pipeline flush
+// when the awaited store arrives.
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+// Spinning only pays while the thread being waited for runs on another CPU.
+inline bool spinning_can_help() {
+  static const bool result = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+  return result;
+}
+
+}
+
+// How a queue operation that cannot proceed waits. It first spins, re-checking the queue
+// with a pause in between, for up to max_spins rounds; past that it parks on a futex until
+// the other side wakes it. Each wait point tunes its own limit from the rounds recent
+// successful spins took (as glibc's adaptive mutexes do), so when the other side is only
+// momentarily behind the hand-off happens with no system call on either side, and when it
+// is idle the spinning dies down to a few rounds. With max_spins 0, or on a machine with a
+// single CPU, a caller parks at once.
+struct QueueWait {
+  uint32_t max_spins;
+
+  // A pause is roughly 10 to 150 cycles depending on the core, so the default caps a spin
+  // at a few microseconds to some tens of them.
+  static constexpr QueueWait adaptive(uint32_t max_spins = 1024) { return QueueWait{max_spins}; }
+  static constexpr QueueWait park() { return QueueWait{0}; }
+};
+
+// Where a thread waits after its attempt on a queue failed. Sleepers park on a futex over
+// _sequence, which every wake-up bumps; a sleeper reads it before it registers, so a
+// wake-up that lands between its last check and its sleep makes the sleep return at once
+// instead of being lost. Like a condition variable it remembers how many registered
+// sleepers were already sent a wake-up, so once all have been, including while they have
+// yet to run, notifying costs one atomic load and no system call. Waiters write its state
+// while notifiers read it, so it keeps a cache line to itself.
+class alignas(64) QueueSignal {
+  // Below this the limit never shrinks, so an idle spell does not stop spinning for good.
+  static constexpr uint32_t MIN_SPINS = 16;
+  // _sleepers counts registered sleepers in the low half and wake-ups sent in the high half.
+  static constexpr uint64_t REGISTERED = 1;
+  static constexpr uint64_t WOKEN = uint64_t(1) << 32;
+
+  std::atomic<uint32_t> _sequence;
+  std::atomic<uint64_t> _sleepers;
+  std::atomic<uint32_t> _spins;  // running average of rounds a spin took, 0 for a failed one
+  const uint32_t _max_spins;
+
+  // The spinning half of wait(): whether ready() came true within the current limit.
+  template <typename Ready>
+  bool spin(Ready& ready) {
+    if (_max_spins == 0) {
+      return false;
+    }
+    uint32_t average = _spins.load(std::memory_order_relaxed);
+    uint32_t limit = std::min(_max_spins, 2 * average + MIN_SPINS);
+    uint32_t rounds = 0;
+    bool result = false;
+    while (rounds < limit && !(result = ready())) {
+      queue_detail::cpu_relax();
+      ++rounds;
+    }
+    auto sample = static_cast<int32_t>(result ? rounds : 0);
+    auto updated =
+        static_cast<uint32_t>(static_cast<int32_t>(average) + (sample - static_cast<int32_t>(average)) / 8);
+    // Settled averages are common; skipping the store leaves the line shared.
+    if (updated != average) {
+      _spins.store(updated, std::memory_order_relaxed);
+    }
+    return result;
+  }
+
+  // A sleeper leaving takes one wake-up with it, whether or not it was the one woken: that
+  // can only undercount them, which costs a spare wake-up later but never a lost one.
+  void leave() {
+    uint64_t sleepers = _sleepers.load(std::memory_order_relaxed);
+    while (!_sleepers.compare_exchange_weak(sleepers, sleepers - REGISTERED - (sleepers >= WOKEN ? WOKEN : 0),
+                                            std::memory_order_relaxed)) {
+    }
+  }
+
+public:
+  explicit QueueSignal(QueueWait wait)
+      : _sequence(0), _sleepers(0), _spins(0),
+        _max_spins(queue_detail::spinning_can_help() ? wait.max_spins : 0) {}
+
+  QueueSignal(const QueueSignal&) = delete;
+  QueueSignal& operator=(const QueueSignal&) = delete;
+
+  // Blocks until ready() holds, or until the deadline if there is one; returns ready().
+  // A sleeper registers before it checks ready(), and the notifier changes the state before
+  // it reads _sleepers; with the change and the reads in ready() all seq_cst, either the
+  // sleeper sees the change or the notifier sees the sleeper and bumps _sequence under it.
+  template <typename Ready>
+  bool wait(Ready ready, const timespec* deadline = nullptr) {
+    if (spin(ready)) {
+      return true;
+    }
+    for (;;) {
+      uint32_t sequence = _sequence.load(std::memory_order_seq_cst);
+      _sleepers.fetch_add(REGISTERED, std::memory_order_seq_cst);
+      bool result = ready();
+      bool timed_out = false;
+      if (!result) {
+        timed_out = !queue_detail::futex_wait(_sequence, sequence, deadline);
+        result = ready();
+      }
+      leave();
+      if (result || timed_out) {
+        return result;
+      }
+    }
+  }
+
+  void notify_one() { notify(1); }
+  void notify_all() { notify(SIZE_MAX); }
+
+  // One element readies one sleeper, several may ready them all.
+  void notify(size_t count) {
+    if (count == 0) {
+      return;
+    }
+    uint64_t sleepers = _sleepers.load(std::memory_order_seq_cst);
+    uint64_t next;
+    do {
+      uint64_t registered = sleepers & (WOKEN - 1);
+      if (sleepers / WOKEN >= registered) {
+        return;
+      }
+      next = count == 1 ? sleepers + WOKEN : registered * WOKEN + registered;
+    } while (!_sleepers.compare_exchange_weak(sleepers, next, std::memory_order_seq_cst));
+    _sequence.fetch_add(1, std::memory_order_seq_cst);
+    queue_detail::futex_wake(_sequence, count == 1 ? 1 : INT_MAX);
+  }
+};
+
+// One std::queue behind a mutex: every operation takes the lock, so under many producers
+// the queue becomes a convoy on it. Blocked callers wait outside the lock, on atomic copies
+// of the size and the done flag that are written under it.
+template <typename T>
+class MutexQueue {
+  std::queue<T> queue;
+  const size_t max_size;
+  pthread_mutex_t mutex;
+  std::atomic<size_t> size;
+  std::atomic<bool> done;
+  QueueSignal not_full;
+  QueueSignal not_empty;
+
+  bool can_push() const {
+    return size.load(std::memory_order_seq_cst) < max_size || done.load(std::memory_order_seq_cst);
+  }
+
+  bool can_pop() const {
+    return size.load(std::memory_order_seq_cst) > 0 || done.load(std::memory_order_seq_cst);
+  }
+
+  // Both expect the mutex held; the caller wakes the other side once it has unlocked, so
+  // the woken thread does not run straight into the lock.
+  size_t push_locked(std::span<T> items) {
+    size_t count = std::min(items.size(), max_size - std::min(max_size, queue.size()));
+    for (size_t i = 0; i < count; ++i) {
+      queue.push(std::move(items[i]));
+    }
+    size.store(queue.size(), std::memory_order_seq_cst);
+    return count;
+  }
+
+  size_t pop_locked(std::span<T> out, size_t max) {
+    size_t count = std::min({out.size(), max, queue.size()});
+    for (size_t i = 0; i < count; ++i) {
+      out[i] = std::move(queue.front());
+      queue.pop();
+    }
+    size.store(queue.size(), std::memory_order_seq_cst);
+    return count;
+  }
+
+  // A failed attempt constructs nothing, so the arguments are still intact for the retry.
+  template <typename... Args>
+  QueueStatus emplace_until(const timespec* deadline, Args&&... args) {
+    for (;;) {
+      check_result(pthread_mutex_lock(&mutex));
+      bool closed = done.load(std::memory_order_relaxed);
+      bool pushed = !closed && queue.size() < max_size;
+      if (pushed) {
+        queue.emplace(std::forward<Args>(args)...);
+        size.store(queue.size(), std::memory_order_seq_cst);
+      }
+      check_result(pthread_mutex_unlock(&mutex));
+      if (pushed) {
+        not_empty.notify_one();
+        return QueueStatus::Ok;
+      }
+      if (closed) {
+        return QueueStatus::Closed;
+      }
+      if (!not_full.wait([this] { return can_push(); }, deadline)) {
+        return QueueStatus::Timeout;
+      }
+    }
+  }
+
+  // Elements still queued are handed out after set_done(); Closed only once drained.
+  QueueStatus dequeue_until(const timespec* deadline, std::optional<T>& out) {
+    for (;;) {
+      check_result(pthread_mutex_lock(&mutex));
+      bool popped = !queue.empty();
+      if (popped) {
+        out.emplace(std::move(queue.front()));
+        queue.pop();
+        size.store(queue.size(), std::memory_order_seq_cst);
+      }
+      bool closed = done.load(std::memory_order_relaxed);
+      check_result(pthread_mutex_unlock(&mutex));
+      if (popped) {
+        not_full.notify_one();
+        return QueueStatus::Ok;
+      }
+      if (closed) {
+        return QueueStatus::Closed;
+      }
+      if (!not_empty.wait([this] { return can_pop(); }, deadline)) {
+        return QueueStatus::Timeout;
+      }
+    }
+  }
+
+public:
+  MutexQueue(size_t max_size, QueueWait wait = QueueWait::adaptive())
+      : max_size(max_size), size(0), done(false), not_full(wait), not_empty(wait) {
+    check_result(pthread_mutex_init(&mutex, nullptr));
+  }
+
+  ~MutexQueue() { check_result(pthread_mutex_destroy(&mutex)); }
+
+  MutexQueue(const MutexQueue&) = delete;
+  MutexQueue(MutexQueue&&) = delete;
+
+  template <typename... Args>
+  bool emplace(Args&&... args) {
+    return emplace_until(nullptr, std::forward<Args>(args)...) == QueueStatus::Ok;
+  }
+
+  bool enqueue(const T& v) { return emplace(v); }
+  bool enqueue(T&& v) { return emplace(std::move(v)); }
+
+  std::optional<T> dequeue() {
+    std::optional<T> val;
+    dequeue_until(nullptr, val);
+    return val;
+  }
+
+  template <typename Rep, typename Period>
+  QueueStatus enqueue_for(const T& v, const std::chrono::duration<Rep, Period>& timeout) {
+    timespec deadline = queue_detail::deadline_after(timeout);
+    return emplace_until(&deadline, v);
+  }
+
+  template <typename Rep, typename Period>
+  QueueStatus enqueue_for(T&& v, const std::chrono::duration<Rep, Period>& timeout) {
+    timespec deadline = queue_detail::deadline_after(timeout);
+    return emplace_until(&deadline, std::move(v));
+  }
+
+  template <typename Rep, typename Period>
+  QueueStatus dequeue_for(T& out, const std::chrono::duration<Rep, Period>& timeout) {
+    timespec deadline = queue_detail::deadline_after(timeout);
+    std::optional<T> val;
+    QueueStatus status = dequeue_until(&deadline, val);
+    if (status == QueueStatus::Ok) {
+      out = std::move(*val);
+    }
+    return status;
+  }
+
+  std::optional<T> try_dequeue() {
+    std::optional<T> val;
+    check_result(pthread_mutex_lock(&mutex));
+    if (!queue.empty()) {
+      val.emplace(std::move(queue.front()));
+      queue.pop();
+      size.store(queue.size(), std::memory_order_seq_cst);
+    }
+    check_result(pthread_mutex_unlock(&mutex));
+    if (val) {
+      not_full.notify_one();
+    }
+    return val;
+  }
+
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    check_result(pthread_mutex_lock(&mutex));
+    bool pushed = queue.size() < max_size;
+    if (pushed) {
+      queue.emplace(std::forward<Args>(args)...);
+      size.store(queue.size(), std::memory_order_seq_cst);
+    }
+    check_result(pthread_mutex_unlock(&mutex));
+    if (pushed) {
+      not_empty.notify_one();
+    }
+    return pushed;
+  }
+
+  bool try_enqueue(const T& v) { return try_emplace(v); }
+  bool try_enqueue(T&& v) { return try_emplace(std::move(v)); }
+
+  size_t enqueue_bulk(std::span<T> items) {
+    size_t moved = 0;
+    while (moved < items.size()) {
+      check_result(pthread_mutex_lock(&mutex));
+      bool closed = done.load(std::memory_order_relaxed);
+      size_t count = closed ? 0 : push_locked(items.subspan(moved));
+      check_result(pthread_mutex_unlock(&mutex));
+      not_empty.notify(count);
+      moved += count;
+      if (closed) {
+        break;
+      }
+      if (count == 0) {
+        not_full.wait([this] { return can_push(); });
+      }
+    }
+    return moved;
+  }
+
+  size_t try_enqueue_bulk(std::span<T> items) {
+    check_result(pthread_mutex_lock(&mutex));
+    size_t moved = push_locked(items);
+    check_result(pthread_mutex_unlock(&mutex));
+    not_empty.notify(moved);
+    return moved;
+  }
+
+  size_t dequeue_bulk(std::span<T> out, size_t max = SIZE_MAX) {
+    if (out.empty() || max == 0) {
+      return 0;
+    }
+    for (;;) {
+      check_result(pthread_mutex_lock(&mutex));
+      size_t moved = pop_locked(out, max);
+      bool closed = done.load(std::memory_order_relaxed);
+      check_result(pthread_mutex_unlock(&mutex));
+      not_full.notify(moved);
+      if (moved > 0 || closed) {
+        return moved;
+      }
+      not_empty.wait([this] { return can_pop(); });
+    }
+  }
+
+  size_t try_dequeue_bulk(std::span<T> out, size_t max = SIZE_MAX) {
+    check_result(pthread_mutex_lock(&mutex));
+    size_t moved = pop_locked(out, max);
+    check_result(pthread_mutex_unlock(&mutex));
+    not_full.notify(moved);
+    return moved;
+  }
+
+  bool full() const { return size.load(std::memory_order_acquire) >= max_size; }
+
+  bool empty() const { return size.load(std::memory_order_acquire) == 0; }
+
+  void set_done() {
+    check_result(pthread_mutex_lock(&mutex));
+    done.store(true, std::memory_order_seq_cst);
+    check_result(pthread_mutex_unlock(&mutex));
+    not_empty.notify_all();
+    not_full.notify_all();
+  }
+};
+
+// Whether one thread or many use a side (producers or consumers) of a RingQueue.
+enum class Sharing { Single, Multiple };
+
+// Bounded ring (Vyukov): every cell carries a sequence number that tells producers and
+// consumers whose turn it is, so neither side reads the other's position on its fast path.
+// A side shared by several threads claims cells with one CAS on its position (lock-free);
+// a side owned by one thread just advances it, which makes that side wait-free. An SPSC
+// element costs a plain store of the position and a seq_cst store of the cell's sequence,
+// plus the seq_cst load of the other side's sleeper count that publish() makes to see
+// whether to notify; only when someone sleeps does it call into the kernel. Head, tail,
+// the read-mostly fields and each signal sit on lines of their own. Capacity is max_size
+// rounded up to a power of two, at least 2. Using a Single side from more than one thread
+// at a time is undefined.
+// A claimed cell must be published, or every later caller on that side waits for it
+// forever, so nothing may throw between a claim and its publication: T needs a noexcept
+// move, and a value whose construction can throw (a copy, or emplace arguments) is built
+// before the cell is claimed. A try_ that then finds the ring full drops that value, so
+// rvalue arguments may be left moved-from; emplace builds it once and retries with it.
+template <typename T, Sharing Producers, Sharing Consumers>
+class RingQueue {
+  static_assert(std::is_nothrow_move_constructible_v<T>, "RingQueue elements need a noexcept move");
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T* value() { return std::launder(reinterpret_cast<T*>(storage)); }
+  };
+
+  alignas(64) std::atomic<size_t> _tail;  // next position to enqueue
+  alignas(64) std::atomic<size_t> _head;  // next position to dequeue
+  alignas(64) std::atomic<bool> _done;   // read on every operation, written once
+  std::unique_ptr<Cell[]> _cells;
+  size_t _mask;
+  QueueSignal _not_empty;                // each on a line of its own, see QueueSignal
+  QueueSignal _not_full;
+
+  // Claims up to max consecutive cells for one side, starting at the position returned in
+  // pos, once their sequences show it is that side's turn: the cell at p is a producer's
+  // when its sequence is p (lag 0) and a consumer's when it is p + 1 (lag 1). Returns how
+  // many were claimed; 0 if the ring is full or empty respectively.
+  template <Sharing Side>
+  size_t claim(std::atomic<size_t>& position, size_t lag, size_t max, size_t& pos) {
+    pos = position.load(std::memory_order_relaxed);
+    for (;;) {
+      size_t sequence = _cells[pos & _mask].sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + lag);
+      if (diff < 0) {
+        return 0;
+      }
+      if (diff > 0) {
+        pos = position.load(std::memory_order_relaxed);  // another thread took this cell
+        continue;
+      }
+
+      size_t count = 1;
+      while (count < max && count <= _mask &&
+             _cells[(pos + count) & _mask].sequence.load(std::memory_order_acquire) == pos + count + lag) {
+        ++count;
+      }
+      if constexpr (Side == Sharing::Single) {
+        position.store(pos + count, std::memory_order_relaxed);
+        return count;
+      } else if (position.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+        return count;
+      }
+    }
+  }
+
+  // Hands cells [pos, pos + count) to the other side by setting their sequences to
+  // pos + offset onwards, then wakes it. The publication has to be ordered before the
+  // sleeper count is read (see QueueSignal::wait): one seq_cst store does that for a single
+  // cell, a batch uses release stores and one fence.
+  void publish(size_t pos, size_t count, size_t offset, QueueSignal& signal) {
+    if (count == 1) {
+      _cells[pos & _mask].sequence.store(pos + offset, std::memory_order_seq_cst);
+      signal.notify_one();
+      return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+      _cells[(pos + i) & _mask].sequence.store(pos + i + offset, std::memory_order_release);
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    signal.notify_all();
+  }
+
+  void publish_enqueued(size_t pos, size_t count) { publish(pos, count, 1, _not_empty); }
+  void publish_dequeued(size_t pos, size_t count) { publish(pos, count, _mask + 1, _not_full); }
+
+  // seq_cst so that QueueSignal::wait pairs with the publishing stores below.
+  bool can_enqueue() const {
+    size_t pos = _tail.load(std::memory_order_seq_cst);
+    return _cells[pos & _mask].sequence.load(std::memory_order_seq_cst) == pos;
+  }
+
+  bool can_dequeue() const {
+    size_t pos = _head.load(std::memory_order_seq_cst);
+    return _cells[pos & _mask].sequence.load(std::memory_order_seq_cst) == pos + 1;
+  }
+
+  bool drained() const {
+    return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+  }
+
+  template <typename... Args>
+  QueueStatus emplace_until(const timespec* deadline, Args&&... args) {
+    if constexpr (!std::is_nothrow_constructible_v<T, Args&&...>) {
+      // try_emplace would build a fresh value on every attempt.
+      return emplace_until(deadline, T(std::forward<Args>(args)...));
+    }
+    while (!_done.load(std::memory_order_acquire)) {
+      if (try_emplace(std::forward<Args>(args)...)) {
+        return QueueStatus::Ok;
+      }
+      if (!_not_full.wait([this] { return _done.load(std::memory_order_seq_cst) || can_enqueue(); }, deadline)) {
+        return QueueStatus::Timeout;
+      }
+    }
+    return QueueStatus::Closed;
+  }
+
+  QueueStatus dequeue_until(const timespec* deadline, std::optional<T>& out) {
+    for (;;) {
+      if ((out = try_dequeue())) {
+        return QueueStatus::Ok;
+      }
+      if (_done.load(std::memory_order_acquire)) {
+        // Enqueues that won their cell before set_done() may still be publishing it.
+        if (drained()) {
+          return QueueStatus::Closed;
+        }
+        continue;
+      }
+      if (!_not_empty.wait([this] { return _done.load(std::memory_order_seq_cst) || can_dequeue(); }, deadline)) {
+        return QueueStatus::Timeout;
+      }
+    }
+  }
+
+public:
+  RingQueue(size_t max_size, QueueWait wait = QueueWait::adaptive())
+      : _tail(0), _head(0), _done(false), _not_empty(wait), _not_full(wait) {
+    size_t capacity = 2;  // with one cell a published element reads as a free one
+    while (capacity < max_size)
+      capacity <<= 1;
+    _cells.reset(new Cell[capacity]);
+    _mask = capacity - 1;
+    for (size_t i = 0; i < capacity; ++i) {
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~RingQueue() {
+    size_t pos = 0;
+    while (claim<Consumers>(_head, 1, 1, pos) != 0) {
+      _cells[pos & _mask].value()->~T();
+    }
+  }
+
+  RingQueue(const RingQueue&) = delete;
+  RingQueue(RingQueue&&) = delete;
+
+  size_t capacity() const { return _mask + 1; }
+
+  template <typename... Args>
+  bool try_emplace(Args&&... args) {
+    if constexpr (!std::is_nothrow_constructible_v<T, Args&&...>) {
+      if (!can_enqueue()) {
+        return false;  // full: do not build a value only to drop it
+      }
+      return try_emplace(T(std::forward<Args>(args)...));
+    }
+    size_t pos = 0;
+    if (claim<Producers>(_tail, 0, 1, pos) == 0) {
+      return false;
+    }
+    new (_cells[pos & _mask].storage) T(std::forward<Args>(args)...);
+    publish_enqueued(pos, 1);
+    return true;
+  }
+
+  bool try_enqueue(const T& v) { return try_emplace(v); }
+  bool try_enqueue(T&& v) { return try_emplace(std::move(v)); }
+
+  std::optional<T> try_dequeue() {
+    size_t pos = 0;
+    if (claim<Consumers>(_head, 1, 1, pos) == 0) {
+      return std::nullopt;
+    }
+    T* value = _cells[pos & _mask].value();
+    std::optional<T> val(std::move(*value));
+    value->~T();
+    publish_dequeued(pos, 1);
+    return val;
+  }
+
+  size_t try_enqueue_bulk(std::span<T> items) {
+    size_t pos = 0;
+    size_t count = items.empty() ? 0 : claim<Producers>(_tail, 0, items.size(), pos);
+    for (size_t i = 0; i < count; ++i) {
+      new (_cells[(pos + i) & _mask].storage) T(std::move(items[i]));
+    }
+    if (count > 0) {
+      publish_enqueued(pos, count);
+    }
+    return count;
+  }
+
+  size_t try_dequeue_bulk(std::span<T> out, size_t max = SIZE_MAX) {
+    static_assert(std::is_nothrow_move_assignable_v<T>, "Bulk dequeues need a noexcept move assignment");
+    size_t pos = 0;
+    size_t limit = std::min(out.size(), max);
+    size_t count = limit == 0 ? 0 : claim<Consumers>(_head, 1, limit, pos);
+    for (size_t i = 0; i < count; ++i) {
+      T* value = _cells[(pos + i) & _mask].value();
+      out[i] = std::move(*value);
+      value->~T();
+    }
+    if (count > 0) {
+      publish_dequeued(pos, count);
+    }
+    return count;
+  }
+
+  // Every attempt uses the same arguments, or the same value built from them once.
+  template <typename... Args>
+  bool emplace(Args&&... args) {
+    return emplace_until(nullptr, std::forward<Args>(args)...) == QueueStatus::Ok;
+  }
+
+  bool enqueue(const T& v) { return emplace(v); }
+  bool enqueue(T&& v) { return emplace(std::move(v)); }
+
+  std::optional<T> dequeue() {
+    std::optional<T> val;
+    dequeue_until(nullptr, val);
+    return val;
+  }
+
+  template <typename Rep, typename Period>
+  QueueStatus enqueue_for(const T& v, const std::chrono::duration<Rep, Period>& timeout) {
+    timespec deadline = queue_detail::deadline_after(timeout);
+    return emplace_until(&deadline, v);
+  }
+
+  template <typename Rep, typename Period>
+  QueueStatus enqueue_for(T&& v, const std::chrono::duration<Rep, Period>& timeout) {
+    timespec deadline = queue_detail::deadline_after(timeout);
+    return emplace_until(&deadline, std::move(v));
+  }
+
+  template <typename Rep, typename Period>
+  QueueStatus dequeue_for(T& out, const std::chrono::duration<Rep, Period>& timeout) {
+    timespec deadline = queue_detail::deadline_after(timeout);
+    std::optional<T> val;
+    QueueStatus status = dequeue_until(&deadline, val);
+    if (status == QueueStatus::Ok) {
+      out = std::move(*val);
+    }
+    return status;
+  }
+
+  size_t enqueue_bulk(std::span<T> items) {
+    size_t moved = 0;
+    while (moved < items.size() && !_done.load(std::memory_order_acquire)) {
+      size_t count = try_enqueue_bulk(items.subspan(moved));
+      moved += count;
+      if (count == 0) {
+        _not_full.wait([this] { return _done.load(std::memory_order_seq_cst) || can_enqueue(); });
+      }
+    }
+    return moved;
+  }
+
+  size_t dequeue_bulk(std::span<T> out, size_t max = SIZE_MAX) {
+    if (out.empty() || max == 0) {
+      return 0;
+    }
+    for (;;) {
+      if (size_t count = try_dequeue_bulk(out, max)) {
+        return count;
+      }
+      if (_done.load(std::memory_order_acquire)) {
+        if (drained()) {
+          return 0;
+        }
+        continue;
+      }
+      _not_empty.wait([this] { return _done.load(std::memory_order_seq_cst) || can_dequeue(); });
+    }
+  }
+
+  bool full() const { return !can_enqueue(); }
+
+  bool empty() const { return drained(); }
+
+  void set_done() {
+    _done.store(true, std::memory_order_seq_cst);
+    _not_empty.notify_all();
+    _not_full.notify_all();
+  }
+};
+
+template <typename T>
+using MpmcQueue = RingQueue<T, Sharing::Multiple, Sharing::Multiple>;
+template <typename T>
+using MpscQueue = RingQueue<T, Sharing::Multiple, Sharing::Single>;
+template <typename T>
+using SpscQueue = RingQueue<T, Sharing::Single, Sharing::Single>;
+
+// Call sites name a policy and keep the same code whichever queue it selects.
+namespace queue_policy {
+
+// MutexQueue: simplest, and fine while the queue is not contended.
+struct Mutex {
+  template <typename T>
+  using queue = MutexQueue<T>;
+};
+
+// Any number of producers and consumers, lock-free.
+struct Mpmc {
+  template <typename T>
+  using queue = MpmcQueue<T>;
+};
+
+// Any number of producers, lock-free; one consumer thread, wait-free.
+struct Mpsc {
+  template <typename T>
+  using queue = MpscQueue<T>;
+};
+
+// One producer thread and one consumer thread, both wait-free.
+struct Spsc {
+  template <typename T>
+  using queue = SpscQueue<T>;
+};
+
+}
+
+template <typename T, typename Policy = queue_policy::Mutex>
+using ThreadSafeQueue = typename Policy::template queue<T>;
+
+#endif
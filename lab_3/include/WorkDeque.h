@@ -0,0 +1,80 @@
+#ifndef WORK_DEQUE_H
+#define WORK_DEQUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Chase-Lev work-stealing deque of task indices with a fixed capacity.
+// The owner pushes and pops at the bottom; any other thread may steal from the top.
+// reset() must not run concurrently with any other operation.
+class WorkDeque {
+  alignas(64) std::atomic<int64_t> _top;
+  alignas(64) std::atomic<int64_t> _bottom;
+  std::vector<std::atomic<size_t>> _buffer;
+  size_t _mask;
+
+public:
+  enum class Steal { Empty, Lost, Taken };
+
+  WorkDeque() : _top(0), _bottom(0), _buffer(1), _mask(0) {}
+
+  void reset(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    if (size > _buffer.size()) {
+      _buffer = std::vector<std::atomic<size_t>>(size);
+    }
+    _mask = _buffer.size() - 1;
+    _top.store(0, std::memory_order_relaxed);
+    _bottom.store(0, std::memory_order_relaxed);
+  }
+
+  // Owner only. Capacity is fixed by reset(), so the caller must not overfill.
+  void push(size_t item) {
+    int64_t b = _bottom.load(std::memory_order_relaxed);
+    _buffer[b & _mask].store(item, std::memory_order_relaxed);
+    _bottom.store(b + 1, std::memory_order_release);
+  }
+
+  // Owner only.
+  bool pop(size_t& item) {
+    int64_t b = _bottom.load(std::memory_order_relaxed) - 1;
+    _bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = _top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      _bottom.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    item = _buffer[b & _mask].load(std::memory_order_relaxed);
+    if (t == b) {
+      // Last element: race the thieves for it.
+      bool won = _top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      _bottom.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread. Lost means another thread won the race and the caller may retry.
+  Steal steal(size_t& item) {
+    int64_t t = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = _bottom.load(std::memory_order_acquire);
+
+    if (t >= b) {
+      return Steal::Empty;
+    }
+    item = _buffer[t & _mask].load(std::memory_order_relaxed);
+    if (!_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return Steal::Lost;
+    }
+    return Steal::Taken;
+  }
+};
+
+#endif
@@ -1,13 +1,14 @@
 #include <iostream>
-#include <chrono>
 #include <cmath>
+#include <algorithm>
 
 #include "include/Matrix.h"
+#include "include/Gemm.h"
+#include "include/OutOfCore.h"
+#include "include/ThreadPool.h"
 
 int main() {
     try {
-        std::srand(std::time(nullptr));
-
         Matrix m1(100, 1, 10);
         Matrix m2(100, 1, 10);
 
@@ -18,31 +19,58 @@ int main() {
         m2.write_to_file("matrix_2.bin");
         //m2.print();
 
-        // Sequential multiplication
-        auto start = std::chrono::high_resolution_clock::now();
+        std::cout << "\nGEMM kernel: " << gemm_isa_name() << "\n";
+
+        // Sequential multiplication; timings live in bench_matrix
         Matrix m3 = m1.multiply(m2);
-        auto end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> sequential_time = end - start;
         std::cout << "\nMatrix 1 * Matrix 2 (single-threaded):\n";
         //m3.print();
-        std::cout << "Sequential multiplication time: " << sequential_time.count() << "s\n";
+
+        // Check the blocked kernel against the naive loop
+        Matrix reference = m1.multiply_reference(m2);
+        double max_error = 0.0;
+        for (size_t i = 0; i < reference.size(); ++i) {
+            for (size_t j = 0; j < reference.size(); ++j) {
+                max_error = std::max(max_error, std::abs(reference(i, j) - m3(i, j)));
+            }
+        }
+        std::cout << "Max difference from reference: " << max_error << "\n";
 
         // Parallel multiplication
-        start = std::chrono::high_resolution_clock::now();
         Matrix m4 = m1.parallel_multiply(m2);
-        end = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> parallel_time = end - start;
         std::cout << "\nMatrix 1 * Matrix 2 (multi-threaded):\n";
         //m4.print();
-        std::cout << "Parallel multiplication time: " << parallel_time.count() << "s\n";
+
+        std::vector<ThreadPool::WorkerStats> stats = ThreadPool::global().stats();
+        for (size_t i = 0; i < stats.size(); ++i) {
+            std::cout << "  thread " << i << ": " << stats[i].tasks << " tiles, "
+                      << stats[i].steals << " stolen, idle " << stats[i].idle_seconds << "s\n";
+        }
 
         m4.write_to_file("result.bin");
         std::cout << "\nResult written to file.\n";
 
-        Matrix m5 = Matrix::read_from_file("result.bin");
+        Matrix m5 = Matrix<>::read_from_file("result.bin");
         std::cout << "\nMatrix read from file:\n";
         //m5.print();
 
+        const Matrix m6 = Matrix<>::open_mapped("result.bin");
+        std::cout << "\nMatrix mapped from file, matches read: " << (m6(0, 0) == m5(0, 0) ? "yes" : "no") << "\n";
+
+        // Same product straight from the files, as if they did not fit in memory
+        OutOfCoreOptions options;
+        options.memory_budget = 128 * 1024;
+        OutOfCoreStats ooc = multiply_out_of_core("matrix_1.bin", "matrix_2.bin", "result_ooc.bin", options);
+        Matrix m7 = Matrix<>::read_from_file("result_ooc.bin");
+        double ooc_error = 0.0;
+        for (size_t i = 0; i < m7.size(); ++i) {
+            for (size_t j = 0; j < m7.size(); ++j) {
+                ooc_error = std::max(ooc_error, std::abs(m7(i, j) - m4(i, j)));
+            }
+        }
+        std::cout << "\nOut-of-core product in " << ooc.panel_rows << "x" << ooc.panel_cols
+                  << " blocks, max difference: " << ooc_error << "\n";
+
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
@@ -1,114 +1,12 @@
 #include <pthread.h>
-#include <queue>
 #include <iostream>
 #include <optional>
 #include <unistd.h>
 #include <vector>
 
+#include "include/ThreadSafeQueue.h"
 #include "include/check.hpp"
 
-template <typename T>
-class ThreadSafeQueue {
-    std::queue<T> queue;
-    const size_t max_size;
-    mutable pthread_mutex_t mutex;
-    pthread_cond_t not_full;
-    pthread_cond_t not_empty;
-    bool done;
-
-public:
-    ThreadSafeQueue(size_t max_size) : max_size(max_size), done(false) {
-        check_result(pthread_mutex_init(&mutex, nullptr));
-        check_result(pthread_cond_init(&not_full, nullptr));
-        check_result(pthread_cond_init(&not_empty, nullptr));
-    }
-
-    ~ThreadSafeQueue() {
-        check_result(pthread_mutex_destroy(&mutex));
-        check_result(pthread_cond_destroy(&not_full));
-        check_result(pthread_cond_destroy(&not_empty));
-    }
-
-    ThreadSafeQueue(const ThreadSafeQueue&) = delete;
-    ThreadSafeQueue(ThreadSafeQueue&&) = delete;
-
-    void enqueue(const T& v) {
-        check_result(pthread_mutex_lock(&mutex));
-        while (queue.size() >= max_size && !done)
-            check_result(pthread_cond_wait(&not_full, &mutex));
-        if (done) {
-            check_result(pthread_mutex_unlock(&mutex));
-            return;
-        }
-        queue.push(v);
-        check_result(pthread_cond_signal(&not_empty));
-        check_result(pthread_mutex_unlock(&mutex));
-    }
-
-    T dequeue() {
-        check_result(pthread_mutex_lock(&mutex));
-        while (queue.empty() && !done)
-            check_result(pthread_cond_wait(&not_empty, &mutex));
-        if (queue.empty() && done) {
-            check_result(pthread_mutex_unlock(&mutex));
-            return T();
-        }
-        T val = queue.front();
-        queue.pop();
-        check_result(pthread_cond_signal(&not_full));
-        check_result(pthread_mutex_unlock(&mutex));
-        return val;
-    }
-
-    std::optional<T> try_dequeue() {
-        check_result(pthread_mutex_lock(&mutex));
-        if (queue.empty()) {
-            check_result(pthread_mutex_unlock(&mutex));
-            return std::nullopt;
-        }
-        T val = queue.front();
-        queue.pop();
-        check_result(pthread_cond_signal(&not_full));
-        check_result(pthread_mutex_unlock(&mutex));
-        return val;
-    }
-
-    bool try_enqueue(const T& v) {
-        check_result(pthread_mutex_lock(&mutex));
-        if (queue.size() >= max_size) {
-            check_result(pthread_mutex_unlock(&mutex));
-            return false;
-        }
-        queue.push(v);
-        check_result(pthread_cond_signal(&not_empty));
-        check_result(pthread_mutex_unlock(&mutex));
-        return true;
-    }
-
-    bool full() const {
-        check_result(pthread_mutex_lock(&mutex));
-        bool result = queue.size() >= max_size;
-        check_result(pthread_mutex_unlock(&mutex));
-        return result;
-    }
-
-    bool empty() const {
-        check_result(pthread_mutex_lock(&mutex));
-        bool result = queue.empty();
-        check_result(pthread_mutex_unlock(&mutex));
-        return result;
-    }
-
-    void set_done() {
-        check_result(pthread_mutex_lock(&mutex));
-        done = true;
-        check_result(pthread_cond_broadcast(&not_empty));
-        check_result(pthread_cond_broadcast(&not_full));
-        check_result(pthread_mutex_unlock(&mutex));
-    }
-};
-
-
 pthread_mutex_t print_mutex;
 
 struct ThreadArgs {
@@ -141,12 +39,9 @@ void* consumer_thread(void* arg) {
     int id = args->id;
     ThreadSafeQueue<int>& queue = *args->queue;
 
-    while (true) {
-        int val = queue.dequeue();
-        if (val == 0 && queue.empty()) break;
-
+    while (std::optional<int> val = queue.dequeue()) {
         check_result(pthread_mutex_lock(&print_mutex));
-        std::cout << "{Consumer} " << id << " dequeued " << val << std::endl;
+        std::cout << "{Consumer} " << id << " dequeued " << *val << std::endl;
         check_result(pthread_mutex_unlock(&print_mutex));
 
         usleep(150000);
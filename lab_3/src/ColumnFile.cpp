@@ -0,0 +1,36 @@
+#include <stdexcept>
+
+#include "../include/ColumnFile.h"
+
+ColumnFile::ColumnFile(const std::string& filename, MappedFile::Access access)
+    : _file(std::make_shared<MappedFile>(filename, MappedFile::Mode::ReadOnly)) {
+    if (_file->size() % sizeof(int32_t) != 0) {
+        throw std::runtime_error("Column file size is not a multiple of the element size");
+    }
+    _file->advise(access);
+}
+
+const int32_t* ColumnFile::data() const {
+    return reinterpret_cast<const int32_t*>(_file->data());
+}
+
+size_t ColumnFile::size() const {
+    return _file->size() / sizeof(int32_t);
+}
+
+size_t ColumnFile::count(const SearchPredicate& predicate, size_t num_threads) const {
+    return search_count(data(), size(), predicate, num_threads);
+}
+
+std::vector<size_t> ColumnFile::find(const SearchPredicate& predicate, size_t num_threads) const {
+    return search_find(data(), size(), predicate, num_threads);
+}
+
+std::vector<size_t> ColumnFile::count_many(const std::vector<int32_t>& targets, size_t num_threads) const {
+    return search_count_many(data(), size(), targets, num_threads);
+}
+
+std::vector<std::vector<size_t>> ColumnFile::find_many(const std::vector<int32_t>& targets,
+                                                       size_t num_threads) const {
+    return search_find_many(data(), size(), targets, num_threads);
+}
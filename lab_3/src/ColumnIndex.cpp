@@ -0,0 +1,557 @@
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/ColumnIndex.h"
+#include "../include/ThreadPool.h"
+
+namespace {
+
+// On-disk layout, all native-endian:
+//   [0, 64)   IndexHeader
+//   zones     blocks x {int32 min, int32 max}
+//   values    distinct x int32, padded to 8 bytes
+//   directory distinct x blocks x {uint32 cardinality, uint32 reserved, uint64 offset}
+//   payload   from the next 64-byte boundary: the containers, each padded to 8 bytes
+constexpr char MAGIC[8] = {'S', 'P', 'C', 'O', 'L', 'I', 'D', 'X'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t BITMAP_WORDS = INDEX_BLOCK / 64;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t block;
+    uint64_t rows;
+    uint64_t data_version;
+    uint64_t distinct;
+    uint64_t payload_size;
+    uint64_t reserved[2];
+};
+
+static_assert(sizeof(IndexHeader) == 64, "Column index header must stay 64 bytes");
+
+size_t round_up(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+size_t container_bytes(size_t cardinality) {
+    return cardinality <= INDEX_ARRAY_MAX ? round_up(cardinality * sizeof(uint16_t), 8)
+                                          : BITMAP_WORDS * sizeof(uint64_t);
+}
+
+void write_fully(int fd, const void* buffer, size_t size) {
+    const char* in = static_cast<const char*>(buffer);
+    while (size > 0) {
+        ssize_t bytes_written = write(fd, in, size);
+        if (bytes_written <= 0) {
+            throw std::runtime_error("Failed to write column index");
+        }
+        in += bytes_written;
+        size -= bytes_written;
+    }
+}
+
+// Runs fn(block, first, length) for every INDEX_BLOCK of [0, size) on the pool.
+template <typename Fn>
+void for_each_block(size_t size, size_t num_threads, Fn fn) {
+    size_t blocks = (size + INDEX_BLOCK - 1) / INDEX_BLOCK;
+    ThreadPool& pool = ThreadPool::global();
+    size_t workers = num_threads == 0 ? pool.size() : std::min(num_threads, pool.size());
+    pool.parallel_for(blocks, [&](size_t b) {
+        size_t first = b * INDEX_BLOCK;
+        fn(b, first, std::min(INDEX_BLOCK, size - first));
+    }, workers);
+}
+
+// Value spans up to this many use direct tables instead of searching sorted values.
+constexpr int64_t TABLE_SPAN = 1 << 16;
+
+// Sorted distinct values of one block in [min, max], or more than limit of them if it has
+// too many.
+std::vector<int32_t> block_distinct(const int32_t* data, size_t n, int32_t min, int32_t max, size_t limit) {
+    std::vector<int32_t> distinct;
+    if (int64_t(max) - min < TABLE_SPAN) {
+        std::vector<uint8_t> seen(int64_t(max) - min + 1, 0);
+        for (size_t i = 0; i < n; ++i) {
+            seen[data[i] - int64_t(min)] = 1;
+        }
+        for (size_t v = 0; v < seen.size() && distinct.size() <= limit; ++v) {
+            if (seen[v]) {
+                distinct.push_back(static_cast<int32_t>(min + int64_t(v)));
+            }
+        }
+        return distinct;
+    }
+    for (size_t i = 0; i < n && distinct.size() <= limit; ++i) {
+        auto it = std::lower_bound(distinct.begin(), distinct.end(), data[i]);
+        if (it == distinct.end() || *it != data[i]) {
+            distinct.insert(it, data[i]);
+        }
+    }
+    return distinct;
+}
+
+uint64_t modification_time(const std::string& filename) {
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0) {
+        throw std::runtime_error("Failed to stat column file");
+    }
+    return static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000u + static_cast<uint64_t>(st.st_mtim.tv_nsec);
+}
+
+}
+
+ColumnIndex::ColumnIndex(ColumnFile column)
+    : _column(std::move(column)), _data_version(0), _payload_offset(0) {}
+
+ColumnIndex ColumnIndex::build(const ColumnFile& column, size_t max_distinct) {
+    ColumnIndex index(column);
+    const int32_t* data = column.data();
+    size_t size = column.size();
+    size_t blocks = (size + INDEX_BLOCK - 1) / INDEX_BLOCK;
+
+    // First pass: zone map, and each block's distinct values while there are few enough.
+    index._zones.resize(blocks);
+    std::vector<std::vector<int32_t>> distinct(blocks);
+    for_each_block(size, 0, [&](size_t b, size_t first, size_t length) {
+        auto [min, max] = std::minmax_element(data + first, data + first + length);
+        index._zones[b] = {*min, *max};
+        if (max_distinct > 0) {
+            distinct[b] = block_distinct(data + first, length, *min, *max, max_distinct);
+        }
+    });
+
+    bool bitmaps = max_distinct > 0 && blocks > 0;
+    for (size_t b = 0; b < blocks && bitmaps; ++b) {
+        std::vector<int32_t> merged;
+        std::set_union(index._values.begin(), index._values.end(), distinct[b].begin(), distinct[b].end(),
+                       std::back_inserter(merged));
+        index._values = std::move(merged);
+        bitmaps = index._values.size() <= max_distinct;
+    }
+    if (!bitmaps) {
+        index._values.clear();
+        return index;
+    }
+
+    // Second pass: every block buckets its offsets by value and lays out its containers in a
+    // buffer of its own; the buffers are then concatenated into the payload.
+    size_t values = index._values.size();
+    index._directory.resize(values * blocks);
+    std::vector<std::vector<char>> pieces(blocks);
+    int32_t lowest = index._values.front();
+    std::vector<uint16_t> slot;
+    if (int64_t(index._values.back()) - lowest < TABLE_SPAN) {
+        slot.resize(int64_t(index._values.back()) - lowest + 1);
+        for (size_t v = 0; v < values; ++v) {
+            slot[int64_t(index._values[v]) - lowest] = static_cast<uint16_t>(v);
+        }
+    }
+    for_each_block(size, 0, [&](size_t b, size_t first, size_t length) {
+        std::vector<std::vector<uint16_t>> buckets(values);
+        for (size_t i = 0; i < length; ++i) {
+            int32_t value = data[first + i];
+            size_t v = !slot.empty() ? slot[int64_t(value) - lowest]
+                                     : std::lower_bound(index._values.begin(), index._values.end(), value) -
+                                           index._values.begin();
+            buckets[v].push_back(static_cast<uint16_t>(i));
+        }
+
+        size_t bytes = 0;
+        for (const auto& bucket : buckets) {
+            bytes += bucket.empty() ? 0 : container_bytes(bucket.size());
+        }
+        pieces[b].assign(bytes, 0);
+
+        size_t offset = 0;
+        for (size_t v = 0; v < values; ++v) {
+            const auto& bucket = buckets[v];
+            Container& c = index._directory[v * blocks + b];
+            c = {static_cast<uint32_t>(bucket.size()), 0, offset};
+            if (bucket.empty()) {
+                continue;
+            }
+            char* out = pieces[b].data() + offset;
+            if (bucket.size() <= INDEX_ARRAY_MAX) {
+                std::memcpy(out, bucket.data(), bucket.size() * sizeof(uint16_t));
+            } else {
+                auto* bits = reinterpret_cast<uint64_t*>(out);
+                for (uint16_t i : bucket) {
+                    bits[i / 64] |= uint64_t(1) << (i % 64);
+                }
+            }
+            offset += container_bytes(bucket.size());
+        }
+    });
+
+    std::vector<size_t> piece_offsets(blocks + 1, 0);
+    for (size_t b = 0; b < blocks; ++b) {
+        piece_offsets[b + 1] = piece_offsets[b] + pieces[b].size();
+    }
+    index._owned_payload.resize(piece_offsets.back());
+    for (size_t b = 0; b < blocks; ++b) {
+        std::memcpy(index._owned_payload.data() + piece_offsets[b], pieces[b].data(), pieces[b].size());
+        for (size_t v = 0; v < values; ++v) {
+            index._directory[v * blocks + b].offset += piece_offsets[b];
+        }
+    }
+    return index;
+}
+
+void ColumnIndex::save(const std::string& filename, uint64_t data_version) const {
+    IndexHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.block = static_cast<uint32_t>(INDEX_BLOCK);
+    header.rows = _column.size();
+    header.data_version = data_version;
+    header.distinct = _values.size();
+    header.payload_size = payload_size();
+
+    std::string temporary = filename + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open column index for writing");
+    }
+
+    try {
+        size_t values_bytes = round_up(_values.size() * sizeof(int32_t), 8);
+        size_t metadata = sizeof(header) + _zones.size() * sizeof(Zone) + values_bytes +
+                          _directory.size() * sizeof(Container);
+        const char padding[64] = {};
+
+        write_fully(fd, &header, sizeof(header));
+        write_fully(fd, _zones.data(), _zones.size() * sizeof(Zone));
+        write_fully(fd, _values.data(), _values.size() * sizeof(int32_t));
+        write_fully(fd, padding, values_bytes - _values.size() * sizeof(int32_t));
+        write_fully(fd, _directory.data(), _directory.size() * sizeof(Container));
+        write_fully(fd, padding, round_up(metadata, 64) - metadata);
+        write_fully(fd, payload(), payload_size());
+    } catch (...) {
+        close(fd);
+        unlink(temporary.c_str());
+        throw;
+    }
+    close(fd);
+    if (rename(temporary.c_str(), filename.c_str()) != 0) {
+        unlink(temporary.c_str());
+        throw std::runtime_error("Failed to replace column index");
+    }
+}
+
+ColumnIndex ColumnIndex::load(const std::string& filename, const ColumnFile& column) {
+    ColumnIndex index(column);
+    index._mapping = std::make_shared<MappedFile>(filename, MappedFile::Mode::ReadOnly);
+    const MappedFile& file = *index._mapping;
+
+    IndexHeader header;
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("Column index is truncated");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        throw std::runtime_error("Unsupported column index format");
+    }
+    if (header.block != INDEX_BLOCK || header.rows != column.size()) {
+        throw std::runtime_error("Column index does not match the column");
+    }
+
+    size_t blocks = (column.size() + INDEX_BLOCK - 1) / INDEX_BLOCK;
+    size_t values_bytes = round_up(header.distinct * sizeof(int32_t), 8);
+    size_t metadata = sizeof(header) + blocks * sizeof(Zone) + values_bytes +
+                      header.distinct * blocks * sizeof(Container);
+    size_t payload_offset = round_up(metadata, 64);
+    if (header.distinct > INDEX_BLOCK * blocks || file.size() != payload_offset + header.payload_size) {
+        throw std::runtime_error("Column index size does not match its header");
+    }
+
+    const char* in = file.data() + sizeof(header);
+    index._zones.resize(blocks);
+    std::memcpy(index._zones.data(), in, blocks * sizeof(Zone));
+    in += blocks * sizeof(Zone);
+    index._values.resize(header.distinct);
+    std::memcpy(index._values.data(), in, header.distinct * sizeof(int32_t));
+    in += values_bytes;
+    index._directory.resize(header.distinct * blocks);
+    std::memcpy(index._directory.data(), in, index._directory.size() * sizeof(Container));
+
+    // Queries index result vectors with the stored offsets, so each one has to fall inside
+    // its block: arrays strictly ascending below block_size, bitmaps with nothing past it.
+    const char* payload = file.data() + payload_offset;
+    for (size_t i = 0; i < index._directory.size(); ++i) {
+        const Container& c = index._directory[i];
+        size_t length = index.block_size(i % blocks);
+        if (c.cardinality == 0) {
+            continue;
+        }
+        if (c.cardinality > length || c.offset % 8 != 0 ||
+            c.offset + container_bytes(c.cardinality) > header.payload_size) {
+            throw std::runtime_error("Column index container out of range");
+        }
+        if (c.cardinality <= INDEX_ARRAY_MAX) {
+            const auto* offsets = reinterpret_cast<const uint16_t*>(payload + c.offset);
+            for (size_t j = 0; j < c.cardinality; ++j) {
+                if (offsets[j] >= length || (j > 0 && offsets[j] <= offsets[j - 1])) {
+                    throw std::runtime_error("Column index container out of range");
+                }
+            }
+        } else {
+            const auto* bits = reinterpret_cast<const uint64_t*>(payload + c.offset);
+            for (size_t w = length / 64; w < BITMAP_WORDS; ++w) {
+                uint64_t tail = ~uint64_t(0);
+                if (w == length / 64) {
+                    tail <<= length % 64;
+                }
+                if ((bits[w] & tail) != 0) {
+                    throw std::runtime_error("Column index container out of range");
+                }
+            }
+        }
+    }
+
+    index._data_version = header.data_version;
+    index._payload_offset = payload_offset;
+    // Queries read only the containers they select.
+    file.advise(MappedFile::Access::Random);
+    return index;
+}
+
+ColumnIndex ColumnIndex::open(const std::string& data_file, size_t max_distinct) {
+    ColumnFile column(data_file, MappedFile::Access::Normal);
+    uint64_t version = modification_time(data_file);
+    std::string path = path_for(data_file);
+
+    if (::access(path.c_str(), F_OK) == 0) {
+        try {
+            ColumnIndex index = load(path, column);
+            if (index._data_version == version) {
+                return index;
+            }
+        } catch (const std::runtime_error&) {
+            // Unreadable or for another version of the data: rebuilt below.
+        }
+    }
+
+    ColumnIndex index = build(column, max_distinct);
+    index._data_version = version;
+    index.save(path, version);
+    return index;
+}
+
+std::string ColumnIndex::path_for(const std::string& data_file) {
+    return data_file + ".idx";
+}
+
+const ColumnFile& ColumnIndex::column() const {
+    return _column;
+}
+
+uint64_t ColumnIndex::data_version() const {
+    return _data_version;
+}
+
+size_t ColumnIndex::blocks() const {
+    return _zones.size();
+}
+
+bool ColumnIndex::has_bitmaps() const {
+    return !_values.empty();
+}
+
+const std::vector<ColumnIndex::Zone>& ColumnIndex::zones() const {
+    return _zones;
+}
+
+const char* ColumnIndex::payload() const {
+    return _mapping ? _mapping->data() + _payload_offset : _owned_payload.data();
+}
+
+size_t ColumnIndex::payload_size() const {
+    return _mapping ? _mapping->size() - _payload_offset : _owned_payload.size();
+}
+
+const ColumnIndex::Container& ColumnIndex::container(size_t value, size_t block) const {
+    return _directory[value * _zones.size() + block];
+}
+
+size_t ColumnIndex::block_size(size_t block) const {
+    return std::min(INDEX_BLOCK, _column.size() - block * INDEX_BLOCK);
+}
+
+void ColumnIndex::container_offsets(const Container& c, std::vector<uint32_t>& out) const {
+    if (c.cardinality <= INDEX_ARRAY_MAX) {
+        const auto* offsets = reinterpret_cast<const uint16_t*>(payload() + c.offset);
+        out.insert(out.end(), offsets, offsets + c.cardinality);
+        return;
+    }
+    const auto* bits = reinterpret_cast<const uint64_t*>(payload() + c.offset);
+    for (size_t w = 0; w < BITMAP_WORDS; ++w) {
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+            out.push_back(static_cast<uint32_t>(w * 64 + __builtin_ctzll(word)));
+        }
+    }
+}
+
+void ColumnIndex::container_or(const Container& c, uint64_t* bits) const {
+    if (c.cardinality <= INDEX_ARRAY_MAX) {
+        const auto* offsets = reinterpret_cast<const uint16_t*>(payload() + c.offset);
+        for (size_t i = 0; i < c.cardinality; ++i) {
+            bits[offsets[i] / 64] |= uint64_t(1) << (offsets[i] % 64);
+        }
+        return;
+    }
+    const auto* other = reinterpret_cast<const uint64_t*>(payload() + c.offset);
+    for (size_t w = 0; w < BITMAP_WORDS; ++w) {
+        bits[w] |= other[w];
+    }
+}
+
+std::vector<size_t> ColumnIndex::selected_values(const SearchPredicate& predicate) const {
+    std::vector<size_t> selected;
+    switch (predicate.kind) {
+    case SearchPredicate::Kind::Equal:
+    case SearchPredicate::Kind::Range: {
+        int32_t high = predicate.kind == SearchPredicate::Kind::Equal ? predicate.low : predicate.high;
+        auto first = std::lower_bound(_values.begin(), _values.end(), predicate.low);
+        auto last = std::upper_bound(_values.begin(), _values.end(), high);
+        for (auto it = first; it < last; ++it) {
+            selected.push_back(it - _values.begin());
+        }
+        break;
+    }
+    case SearchPredicate::Kind::AnyOf:
+        for (int32_t target : predicate.targets) {
+            auto it = std::lower_bound(_values.begin(), _values.end(), target);
+            if (it != _values.end() && *it == target) {
+                selected.push_back(it - _values.begin());
+            }
+        }
+        std::sort(selected.begin(), selected.end());
+        selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+        break;
+    }
+    return selected;
+}
+
+bool ColumnIndex::zone_may_match(const Zone& zone, const SearchPredicate& predicate) const {
+    switch (predicate.kind) {
+    case SearchPredicate::Kind::Equal:
+        return zone.min <= predicate.low && predicate.low <= zone.max;
+    case SearchPredicate::Kind::Range:
+        return zone.min <= predicate.high && predicate.low <= zone.max;
+    case SearchPredicate::Kind::AnyOf:
+        break;
+    }
+    return std::any_of(predicate.targets.begin(), predicate.targets.end(),
+                       [&](int32_t target) { return zone.min <= target && target <= zone.max; });
+}
+
+bool ColumnIndex::zone_all_match(const Zone& zone, const SearchPredicate& predicate) const {
+    switch (predicate.kind) {
+    case SearchPredicate::Kind::Equal:
+        return zone.min == predicate.low && zone.max == predicate.low;
+    case SearchPredicate::Kind::Range:
+        return predicate.low <= zone.min && zone.max <= predicate.high;
+    case SearchPredicate::Kind::AnyOf:
+        break;
+    }
+    return zone.min == zone.max && predicate.matches(zone.min);
+}
+
+size_t ColumnIndex::count(const SearchPredicate& predicate, size_t num_threads) const {
+    // With bitmaps the stored cardinalities are the answer.
+    if (has_bitmaps()) {
+        size_t total = 0;
+        for (size_t v : selected_values(predicate)) {
+            for (size_t b = 0; b < blocks(); ++b) {
+                total += container(v, b).cardinality;
+            }
+        }
+        return total;
+    }
+
+    std::vector<size_t> counts(blocks(), 0);
+    for_each_block(_column.size(), num_threads, [&](size_t b, size_t first, size_t length) {
+        if (zone_all_match(_zones[b], predicate)) {
+            counts[b] = length;
+        } else if (zone_may_match(_zones[b], predicate)) {
+            counts[b] = search_count(_column.data() + first, length, predicate, 1);
+        }
+    });
+    return std::accumulate(counts.begin(), counts.end(), size_t(0));
+}
+
+std::vector<size_t> ColumnIndex::find(const SearchPredicate& predicate, size_t num_threads) const {
+    std::vector<size_t> selected = has_bitmaps() ? selected_values(predicate) : std::vector<size_t>{};
+
+    // Block-relative offsets per block, concatenated at the end as in search_find.
+    std::vector<std::vector<uint32_t>> matches(blocks());
+    for_each_block(_column.size(), num_threads, [&](size_t b, size_t first, size_t length) {
+        std::vector<uint32_t>& out = matches[b];
+        if (!zone_may_match(_zones[b], predicate)) {
+            return;
+        }
+        if (zone_all_match(_zones[b], predicate)) {
+            out.resize(length);
+            std::iota(out.begin(), out.end(), uint32_t(0));
+            return;
+        }
+        if (!has_bitmaps()) {
+            for (size_t i : search_find(_column.data() + first, length, predicate, 1)) {
+                out.push_back(static_cast<uint32_t>(i));
+            }
+            return;
+        }
+
+        // One value reads its container directly; several are merged through a bitmap so
+        // the offsets come out in order.
+        size_t present = 0;
+        size_t total = 0;
+        const Container* only = nullptr;
+        for (size_t v : selected) {
+            const Container& c = container(v, b);
+            if (c.cardinality > 0) {
+                ++present;
+                total += c.cardinality;
+                only = &c;
+            }
+        }
+        out.reserve(total);
+        if (present == 1) {
+            container_offsets(*only, out);
+        } else if (present > 1) {
+            thread_local std::vector<uint64_t> bits(BITMAP_WORDS);
+            std::fill(bits.begin(), bits.end(), 0);
+            for (size_t v : selected) {
+                const Container& c = container(v, b);
+                if (c.cardinality > 0) {
+                    container_or(c, bits.data());
+                }
+            }
+            for (size_t w = 0; w < BITMAP_WORDS; ++w) {
+                for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+                    out.push_back(static_cast<uint32_t>(w * 64 + __builtin_ctzll(word)));
+                }
+            }
+        }
+    });
+
+    std::vector<size_t> offsets(matches.size() + 1, 0);
+    for (size_t b = 0; b < matches.size(); ++b) {
+        offsets[b + 1] = offsets[b] + matches[b].size();
+    }
+
+    std::vector<size_t> result(offsets.back());
+    for_each_block(_column.size(), num_threads, [&](size_t b, size_t first, size_t) {
+        size_t* out = result.data() + offsets[b];
+        for (uint32_t offset : matches[b]) {
+            *out++ = first + offset;
+        }
+    });
+    return result;
+}
@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../include/Gemm.h"
+#include "../include/GemmKernels.h"
+
+namespace {
+
+// Cache blocking: a KC x NR sliver of B stays in L1, an MC x KC block of A in L2,
+// and a KC x NC panel of B in L3. MC and NC are multiples of every kernel's MR and NR.
+constexpr size_t MC = 96;
+constexpr size_t KC = 256;
+constexpr size_t NC = 2048;
+
+constexpr size_t MAX_TILE = 8 * 32;
+
+// Packs alpha times an mc x kc block of A into mr-row micro-panels of K_GROUP-wide k steps,
+// zero-padding the last panel and the last k group. Folding alpha in here costs nothing
+// extra: every element of A is touched by packing anyway.
+template <typename T>
+void pack_a(size_t mc, size_t kc, const T* a, size_t lda, size_t mr, gemm_acc_t<T> alpha,
+            typename GemmTraits<T>::Packed* packed) {
+    using Packed = typename GemmTraits<T>::Packed;
+    bool scale = alpha != gemm_acc_t<T>(1);
+    constexpr size_t KG = GemmTraits<T>::K_GROUP;
+    size_t steps = (kc + KG - 1) / KG;
+
+    for (size_t ir = 0; ir < mc; ir += mr) {
+        size_t rows = std::min(mr, mc - ir);
+        for (size_t s = 0; s < steps; ++s) {
+            for (size_t i = 0; i < mr; ++i) {
+                for (size_t g = 0; g < KG; ++g) {
+                    size_t p = s * KG + g;
+                    if (i >= rows || p >= kc) {
+                        packed[(s * mr + i) * KG + g] = Packed(0);
+                    } else if (scale) {
+                        packed[(s * mr + i) * KG + g] = static_cast<Packed>(alpha * a[(ir + i) * lda + p]);
+                    } else {
+                        packed[(s * mr + i) * KG + g] = static_cast<Packed>(a[(ir + i) * lda + p]);
+                    }
+                }
+            }
+        }
+        packed += mr * steps * KG;
+    }
+}
+
+// Packs a kc x nc panel of B into nr-column micro-panels of K_GROUP-wide k steps,
+// zero-padding the last panel and the last k group.
+template <typename T>
+void pack_b(size_t kc, size_t nc, const T* b, size_t ldb, size_t nr, typename GemmTraits<T>::Packed* packed) {
+    using Packed = typename GemmTraits<T>::Packed;
+    constexpr size_t KG = GemmTraits<T>::K_GROUP;
+    size_t steps = (kc + KG - 1) / KG;
+
+    for (size_t jr = 0; jr < nc; jr += nr) {
+        size_t cols = std::min(nr, nc - jr);
+        for (size_t s = 0; s < steps; ++s) {
+            if constexpr (KG == 1) {
+                const T* row = b + s * ldb + jr;
+                for (size_t j = 0; j < cols; ++j) {
+                    packed[s * nr + j] = row[j];
+                }
+                for (size_t j = cols; j < nr; ++j) {
+                    packed[s * nr + j] = Packed(0);
+                }
+            } else {
+                for (size_t j = 0; j < nr; ++j) {
+                    for (size_t g = 0; g < KG; ++g) {
+                        size_t p = s * KG + g;
+                        packed[(s * nr + j) * KG + g] = j < cols && p < kc ? static_cast<Packed>(b[p * ldb + jr + j]) : Packed(0);
+                    }
+                }
+            }
+        }
+        packed += nr * steps * KG;
+    }
+}
+
+constexpr size_t GENERIC_MR = 4;
+constexpr size_t GENERIC_NR = 8;
+
+// Portable kernel for types and CPUs without a dedicated one; accumulators stay in registers.
+template <typename T>
+void kernel_generic(size_t steps, const typename GemmTraits<T>::Packed* a, const typename GemmTraits<T>::Packed* b,
+                    gemm_acc_t<T>* c, size_t ldc, bool accumulate) {
+    using Acc = gemm_acc_t<T>;
+    constexpr size_t KG = GemmTraits<T>::K_GROUP;
+
+    Acc acc[GENERIC_MR][GENERIC_NR] = {};
+    for (size_t s = 0; s < steps; ++s) {
+        for (size_t i = 0; i < GENERIC_MR; ++i) {
+            for (size_t j = 0; j < GENERIC_NR; ++j) {
+                for (size_t g = 0; g < KG; ++g) {
+                    acc[i][j] += static_cast<Acc>(a[(s * GENERIC_MR + i) * KG + g]) * static_cast<Acc>(b[(s * GENERIC_NR + j) * KG + g]);
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < GENERIC_MR; ++i) {
+        for (size_t j = 0; j < GENERIC_NR; ++j) {
+            c[i * ldc + j] = accumulate ? c[i * ldc + j] + acc[i][j] : acc[i][j];
+        }
+    }
+}
+
+template <typename T>
+const GemmKernel<T> generic_kernel = {"generic", GENERIC_MR, GENERIC_NR, kernel_generic<T>};
+
+bool cpu_supports(GemmIsa isa) {
+    switch (isa) {
+    case GemmIsa::Auto:
+    case GemmIsa::Generic:
+        return true;
+#ifdef MATRIX_X86_KERNELS
+    case GemmIsa::Sse2:
+        return __builtin_cpu_supports("sse2");
+    case GemmIsa::Avx2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case GemmIsa::Avx512:
+        return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+        return false;
+    }
+}
+
+GemmIsa best_isa() {
+    for (GemmIsa isa : {GemmIsa::Avx512, GemmIsa::Avx2, GemmIsa::Sse2}) {
+        if (cpu_supports(isa)) {
+            return isa;
+        }
+    }
+    return GemmIsa::Generic;
+}
+
+// Widest kernel for T that is no wider than isa, which is already known to be supported.
+template <typename T>
+const GemmKernel<T>* kernel_for(GemmIsa isa) {
+#ifdef MATRIX_X86_KERNELS
+    if constexpr (std::is_same_v<T, double>) {
+        switch (isa) {
+        case GemmIsa::Avx512:
+            return &gemm_kernel_avx512_f64;
+        case GemmIsa::Avx2:
+            return &gemm_kernel_avx2_f64;
+        case GemmIsa::Sse2:
+            return &gemm_kernel_sse2_f64;
+        default:
+            break;
+        }
+    } else if constexpr (std::is_same_v<T, float>) {
+        switch (isa) {
+        case GemmIsa::Avx512:
+            return &gemm_kernel_avx512_f32;
+        case GemmIsa::Avx2:
+            return &gemm_kernel_avx2_f32;
+        case GemmIsa::Sse2:
+            return &gemm_kernel_sse2_f32;
+        default:
+            break;
+        }
+    } else if constexpr (std::is_same_v<T, int8_t>) {
+        if (isa == GemmIsa::Avx512 && __builtin_cpu_supports("avx512bw")) {
+            return &gemm_kernel_avx512_i8;
+        }
+        if (isa == GemmIsa::Avx512 || isa == GemmIsa::Avx2) {
+            return &gemm_kernel_avx2_i8;
+        }
+    }
+#endif
+    (void)isa;
+    return &generic_kernel<T>;
+}
+
+GemmIsa isa_from_env() {
+    const char* value = std::getenv("MATRIX_ISA");
+    if (value == nullptr) {
+        return best_isa();
+    }
+
+    std::string name(value);
+    GemmIsa isa = GemmIsa::Auto;
+    if (name == "generic") {
+        isa = GemmIsa::Generic;
+    } else if (name == "sse2") {
+        isa = GemmIsa::Sse2;
+    } else if (name == "avx2") {
+        isa = GemmIsa::Avx2;
+    } else if (name == "avx512") {
+        isa = GemmIsa::Avx512;
+    }
+
+    if (!cpu_supports(isa) || (isa == GemmIsa::Auto && name != "auto")) {
+        std::cerr << "MATRIX_ISA=" << name << " is not available, using automatic selection\n";
+        return best_isa();
+    }
+    return isa == GemmIsa::Auto ? best_isa() : isa;
+}
+
+std::atomic<GemmIsa>& active_isa() {
+    static std::atomic<GemmIsa> isa{isa_from_env()};
+    return isa;
+}
+
+}
+
+void gemm_set_isa(GemmIsa isa) {
+    if (!cpu_supports(isa)) {
+        throw std::invalid_argument("Requested ISA is not supported by this CPU");
+    }
+    active_isa().store(isa == GemmIsa::Auto ? best_isa() : isa, std::memory_order_relaxed);
+}
+
+GemmIsa gemm_isa() {
+    return active_isa().load(std::memory_order_relaxed);
+}
+
+const char* gemm_isa_name() {
+    switch (gemm_isa()) {
+    case GemmIsa::Sse2:
+        return "sse2";
+    case GemmIsa::Avx2:
+        return "avx2";
+    case GemmIsa::Avx512:
+        return "avx512";
+    default:
+        return "generic";
+    }
+}
+
+namespace {
+
+// c = beta * c over an m x n block; beta == 0 overwrites without reading, as in BLAS.
+template <typename Acc>
+void scale_block(size_t m, size_t n, Acc beta, Acc* c, size_t ldc) {
+    for (size_t i = 0; i < m; ++i) {
+        Acc* row = c + i * ldc;
+        if (beta == Acc(0)) {
+            std::fill(row, row + n, Acc(0));
+        } else {
+            for (size_t j = 0; j < n; ++j) {
+                row[j] *= beta;
+            }
+        }
+    }
+}
+
+template <typename T>
+void gemm_run(size_t m, size_t n, size_t k,
+              gemm_acc_t<T> alpha,
+              const T* a, size_t lda,
+              const T* b, size_t ldb,
+              gemm_acc_t<T> beta,
+              gemm_acc_t<T>* c, size_t ldc) {
+    using Acc = gemm_acc_t<T>;
+    using Packed = typename GemmTraits<T>::Packed;
+    constexpr size_t KG = GemmTraits<T>::K_GROUP;
+
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0 || alpha == Acc(0)) {
+        if (beta != Acc(1)) {
+            scale_block(m, n, beta, c, ldc);
+        }
+        return;
+    }
+
+    const GemmKernel<T>& kernel = *kernel_for<T>(active_isa().load(std::memory_order_relaxed));
+    const size_t MR = kernel.mr;
+    const size_t NR = kernel.nr;
+
+    thread_local std::vector<Packed> packed_a;
+    thread_local std::vector<Packed> packed_b;
+    packed_a.resize(MC * KC);
+    packed_b.resize(KC * NC);
+
+    Acc tile[MAX_TILE];
+
+    for (size_t jc = 0; jc < n; jc += NC) {
+        size_t nc = std::min(NC, n - jc);
+        // beta 0 and 1 fold into the first k block (store or accumulate); anything else
+        // needs one pass over this block of C before the products are added in.
+        if (beta != Acc(0) && beta != Acc(1)) {
+            scale_block(m, nc, beta, c + jc, ldc);
+        }
+
+        for (size_t pc = 0; pc < k; pc += KC) {
+            size_t kc = std::min(KC, k - pc);
+            size_t steps = (kc + KG - 1) / KG;
+            bool accumulate = pc != 0 || beta != Acc(0);
+            pack_b(kc, nc, b + pc * ldb + jc, ldb, NR, packed_b.data());
+
+            for (size_t ic = 0; ic < m; ic += MC) {
+                size_t mc = std::min(MC, m - ic);
+                pack_a(mc, kc, a + ic * lda + pc, lda, MR, alpha, packed_a.data());
+
+                for (size_t jr = 0; jr < nc; jr += NR) {
+                    size_t nr = std::min(NR, nc - jr);
+                    const Packed* b_panel = packed_b.data() + jr * steps * KG;
+
+                    for (size_t ir = 0; ir < mc; ir += MR) {
+                        size_t mr = std::min(MR, mc - ir);
+                        const Packed* a_panel = packed_a.data() + ir * steps * KG;
+                        Acc* c_tile = c + (ic + ir) * ldc + jc + jr;
+
+                        if (mr == MR && nr == NR) {
+                            kernel.run(steps, a_panel, b_panel, c_tile, ldc, accumulate);
+                            continue;
+                        }
+
+                        // Edge tile: compute the full register tile aside and copy the valid part.
+                        kernel.run(steps, a_panel, b_panel, tile, NR, false);
+                        for (size_t i = 0; i < mr; ++i) {
+                            for (size_t j = 0; j < nr; ++j) {
+                                Acc& dst = c_tile[i * ldc + j];
+                                dst = accumulate ? dst + tile[i * NR + j] : tile[i * NR + j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
+
+template <typename T>
+void gemm_blocked(size_t m, size_t n, size_t k,
+                  const T* a, size_t lda,
+                  const T* b, size_t ldb,
+                  gemm_acc_t<T>* c, size_t ldc) {
+    gemm_run(m, n, k, gemm_acc_t<T>(1), a, lda, b, ldb, gemm_acc_t<T>(0), c, ldc);
+}
+
+template <typename T>
+void gemm(size_t m, size_t n, size_t k,
+          T alpha,
+          const T* a, size_t lda,
+          const T* b, size_t ldb,
+          T beta,
+          T* c, size_t ldc) {
+    gemm_run(m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+}
+
+template <typename T>
+void gemm_reference(size_t m, size_t n, size_t k,
+                    const T* a, size_t lda,
+                    const T* b, size_t ldb,
+                    gemm_acc_t<T>* c, size_t ldc) {
+    using Acc = gemm_acc_t<T>;
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            Acc sum = 0;
+            for (size_t p = 0; p < k; ++p) {
+                sum += static_cast<Acc>(a[i * lda + p]) * static_cast<Acc>(b[p * ldb + j]);
+            }
+            c[i * ldc + j] = sum;
+        }
+    }
+}
+
+#define INSTANTIATE_GEMM(T)                                                                   \
+    template void gemm_blocked<T>(size_t, size_t, size_t, const T*, size_t, const T*, size_t, \
+                                  gemm_acc_t<T>*, size_t);                                    \
+    template void gemm_reference<T>(size_t, size_t, size_t, const T*, size_t, const T*, size_t, \
+                                    gemm_acc_t<T>*, size_t);
+
+INSTANTIATE_GEMM(float)
+INSTANTIATE_GEMM(double)
+INSTANTIATE_GEMM(int8_t)
+INSTANTIATE_GEMM(int32_t)
+
+template void gemm<float>(size_t, size_t, size_t, float, const float*, size_t, const float*, size_t,
+                          float, float*, size_t);
+template void gemm<double>(size_t, size_t, size_t, double, const double*, size_t, const double*, size_t,
+                           double, double*, size_t);
+template void gemm<int32_t>(size_t, size_t, size_t, int32_t, const int32_t*, size_t, const int32_t*, size_t,
+                            int32_t, int32_t*, size_t);
@@ -0,0 +1,82 @@
+#include <algorithm>
+
+#include "../include/Gemm.h"
+#include "../include/GemmSmallKernels.h"
+#include "../include/ThreadPool.h"
+
+const GemmSmallKernels gemm_small_generic = make_gemm_small_kernels<16>("generic");
+
+namespace {
+
+// Multiply-adds per pool task: enough that the handoff is noise next to the work.
+constexpr size_t MIN_TASK_WORK = 1 << 18;
+
+const GemmSmallKernels& small_kernels() {
+#ifdef MATRIX_X86_KERNELS
+    switch (gemm_isa()) {
+    case GemmIsa::Avx512:
+        return gemm_small_avx512;
+    case GemmIsa::Avx2:
+        return gemm_small_avx2;
+    default:
+        break;
+    }
+#endif
+    return gemm_small_generic;
+}
+
+template <typename T>
+GemmSmallRun<T> small_run(const GemmSmallKernels& kernels) {
+    if constexpr (std::is_same_v<T, double>) {
+        return kernels.f64;
+    } else if constexpr (std::is_same_v<T, float>) {
+        return kernels.f32;
+    } else if constexpr (std::is_same_v<T, int8_t>) {
+        return kernels.i8;
+    } else {
+        return kernels.i32;
+    }
+}
+
+template <typename T>
+void run_range(size_t first, size_t last, size_t m, size_t n, size_t k,
+               const T* a, const T* b, gemm_acc_t<T>* c) {
+    if (n <= GEMM_BATCH_MAX_N) {
+        small_run<T>(small_kernels())(first, last, m, n, k, a, b, c);
+        return;
+    }
+    for (size_t i = first; i < last; ++i) {
+        gemm_blocked(m, n, k, a + i * m * k, k, b + i * k * n, n, c + i * m * n, n);
+    }
+}
+
+}
+
+template <typename T>
+void gemm_batched(size_t count, size_t m, size_t n, size_t k,
+                  const T* a, const T* b, gemm_acc_t<T>* c, size_t num_threads) {
+    if (count == 0 || m == 0 || n == 0) {
+        return;
+    }
+
+    size_t work = std::max<size_t>(m * n * k, 1);
+    size_t chunk = std::max<size_t>(MIN_TASK_WORK / work, 1);
+    size_t tasks = (count + chunk - 1) / chunk;
+
+    ThreadPool& pool = ThreadPool::global();
+    size_t workers = num_threads == 0 ? pool.size() : std::min(num_threads, pool.size());
+    if (tasks == 1 || workers == 1 || ThreadPool::in_task()) {
+        run_range(0, count, m, n, k, a, b, c);
+        return;
+    }
+
+    pool.parallel_for(tasks, [&](size_t t) {
+        run_range(t * chunk, std::min(count, (t + 1) * chunk), m, n, k, a, b, c);
+    }, workers);
+}
+
+template void gemm_batched<float>(size_t, size_t, size_t, size_t, const float*, const float*, float*, size_t);
+template void gemm_batched<double>(size_t, size_t, size_t, size_t, const double*, const double*, double*, size_t);
+template void gemm_batched<int8_t>(size_t, size_t, size_t, size_t, const int8_t*, const int8_t*, int32_t*, size_t);
+template void gemm_batched<int32_t>(size_t, size_t, size_t, size_t, const int32_t*, const int32_t*, int32_t*,
+                                    size_t);
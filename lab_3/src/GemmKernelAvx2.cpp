@@ -0,0 +1,116 @@
+#include <immintrin.h>
+
+#include "../include/GemmKernels.h"
+#include "../include/GemmSmallKernels.h"
+
+namespace {
+
+// 6x8 doubles: 12 ymm accumulators, 2 for the B row and 1 for the broadcast of A.
+void kernel_f64(size_t kc, const double* a, const double* b, double* c, size_t ldc, bool accumulate) {
+    constexpr size_t MR = 6;
+    constexpr size_t NR = 8;
+    __m256d acc[MR][2];
+    for (size_t i = 0; i < MR; ++i) {
+        acc[i][0] = _mm256_setzero_pd();
+        acc[i][1] = _mm256_setzero_pd();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        __m256d b0 = _mm256_loadu_pd(b);
+        __m256d b1 = _mm256_loadu_pd(b + 4);
+        for (size_t i = 0; i < MR; ++i) {
+            __m256d ai = _mm256_broadcast_sd(a + i);
+            acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+        }
+        a += MR;
+        b += NR;
+    }
+
+    for (size_t i = 0; i < MR; ++i) {
+        double* row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm256_add_pd(acc[i][0], _mm256_loadu_pd(row));
+            acc[i][1] = _mm256_add_pd(acc[i][1], _mm256_loadu_pd(row + 4));
+        }
+        _mm256_storeu_pd(row, acc[i][0]);
+        _mm256_storeu_pd(row + 4, acc[i][1]);
+    }
+}
+
+// 6x16 floats, same register budget as the double kernel.
+void kernel_f32(size_t kc, const float* a, const float* b, float* c, size_t ldc, bool accumulate) {
+    constexpr size_t MR = 6;
+    constexpr size_t NR = 16;
+    __m256 acc[MR][2];
+    for (size_t i = 0; i < MR; ++i) {
+        acc[i][0] = _mm256_setzero_ps();
+        acc[i][1] = _mm256_setzero_ps();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        __m256 b0 = _mm256_loadu_ps(b);
+        __m256 b1 = _mm256_loadu_ps(b + 8);
+        for (size_t i = 0; i < MR; ++i) {
+            __m256 ai = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += MR;
+        b += NR;
+    }
+
+    for (size_t i = 0; i < MR; ++i) {
+        float* row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm256_add_ps(acc[i][0], _mm256_loadu_ps(row));
+            acc[i][1] = _mm256_add_ps(acc[i][1], _mm256_loadu_ps(row + 8));
+        }
+        _mm256_storeu_ps(row, acc[i][0]);
+        _mm256_storeu_ps(row + 8, acc[i][1]);
+    }
+}
+
+// 6x16 int8 -> int32. A and B hold int16 pairs of consecutive k, so one vpmaddwd
+// multiplies two k steps and sums them into each int32 lane.
+void kernel_i8(size_t steps, const int16_t* a, const int16_t* b, int32_t* c, size_t ldc, bool accumulate) {
+    constexpr size_t MR = 6;
+    constexpr size_t NR = 16;
+    __m256i acc[MR][2];
+    for (size_t i = 0; i < MR; ++i) {
+        acc[i][0] = _mm256_setzero_si256();
+        acc[i][1] = _mm256_setzero_si256();
+    }
+
+    for (size_t s = 0; s < steps; ++s) {
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 16));
+        for (size_t i = 0; i < MR; ++i) {
+            int32_t pair;
+            __builtin_memcpy(&pair, a + 2 * i, sizeof(pair));
+            __m256i ai = _mm256_set1_epi32(pair);
+            acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_madd_epi16(ai, b0));
+            acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_madd_epi16(ai, b1));
+        }
+        a += 2 * MR;
+        b += 2 * NR;
+    }
+
+    for (size_t i = 0; i < MR; ++i) {
+        __m256i* row = reinterpret_cast<__m256i*>(c + i * ldc);
+        if (accumulate) {
+            acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_loadu_si256(row));
+            acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_loadu_si256(row + 1));
+        }
+        _mm256_storeu_si256(row, acc[i][0]);
+        _mm256_storeu_si256(row + 1, acc[i][1]);
+    }
+}
+
+}
+
+const GemmKernel<double> gemm_kernel_avx2_f64 = {"avx2", 6, 8, kernel_f64};
+const GemmKernel<float> gemm_kernel_avx2_f32 = {"avx2", 6, 16, kernel_f32};
+const GemmKernel<int8_t> gemm_kernel_avx2_i8 = {"avx2", 6, 16, kernel_i8};
+
+const GemmSmallKernels gemm_small_avx2 = make_gemm_small_kernels<32>("avx2");
@@ -0,0 +1,79 @@
+#include <immintrin.h>
+
+#include "../include/GemmKernels.h"
+#include "../include/GemmSmallKernels.h"
+
+namespace {
+
+// 8x16 doubles: 16 zmm accumulators out of 32, leaving room for B and the broadcasts.
+void kernel_f64(size_t kc, const double* a, const double* b, double* c, size_t ldc, bool accumulate) {
+    constexpr size_t MR = 8;
+    constexpr size_t NR = 16;
+    __m512d acc[MR][2];
+    for (size_t i = 0; i < MR; ++i) {
+        acc[i][0] = _mm512_setzero_pd();
+        acc[i][1] = _mm512_setzero_pd();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        __m512d b0 = _mm512_loadu_pd(b);
+        __m512d b1 = _mm512_loadu_pd(b + 8);
+        for (size_t i = 0; i < MR; ++i) {
+            __m512d ai = _mm512_set1_pd(a[i]);
+            acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+        }
+        a += MR;
+        b += NR;
+    }
+
+    for (size_t i = 0; i < MR; ++i) {
+        double* row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm512_add_pd(acc[i][0], _mm512_loadu_pd(row));
+            acc[i][1] = _mm512_add_pd(acc[i][1], _mm512_loadu_pd(row + 8));
+        }
+        _mm512_storeu_pd(row, acc[i][0]);
+        _mm512_storeu_pd(row + 8, acc[i][1]);
+    }
+}
+
+// 8x32 floats, same register budget as the double kernel.
+void kernel_f32(size_t kc, const float* a, const float* b, float* c, size_t ldc, bool accumulate) {
+    constexpr size_t MR = 8;
+    constexpr size_t NR = 32;
+    __m512 acc[MR][2];
+    for (size_t i = 0; i < MR; ++i) {
+        acc[i][0] = _mm512_setzero_ps();
+        acc[i][1] = _mm512_setzero_ps();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        __m512 b0 = _mm512_loadu_ps(b);
+        __m512 b1 = _mm512_loadu_ps(b + 16);
+        for (size_t i = 0; i < MR; ++i) {
+            __m512 ai = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += MR;
+        b += NR;
+    }
+
+    for (size_t i = 0; i < MR; ++i) {
+        float* row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm512_add_ps(acc[i][0], _mm512_loadu_ps(row));
+            acc[i][1] = _mm512_add_ps(acc[i][1], _mm512_loadu_ps(row + 16));
+        }
+        _mm512_storeu_ps(row, acc[i][0]);
+        _mm512_storeu_ps(row + 16, acc[i][1]);
+    }
+}
+
+}
+
+const GemmKernel<double> gemm_kernel_avx512_f64 = {"avx512", 8, 16, kernel_f64};
+const GemmKernel<float> gemm_kernel_avx512_f32 = {"avx512", 8, 32, kernel_f32};
+
+const GemmSmallKernels gemm_small_avx512 = make_gemm_small_kernels<64>("avx512");
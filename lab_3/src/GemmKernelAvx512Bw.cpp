@@ -0,0 +1,44 @@
+#include <immintrin.h>
+
+#include "../include/GemmKernels.h"
+
+namespace {
+
+// 8x32 int8 -> int32 over int16 k-pairs; vpmaddwd on zmm needs AVX-512BW.
+void kernel_i8(size_t steps, const int16_t* a, const int16_t* b, int32_t* c, size_t ldc, bool accumulate) {
+    constexpr size_t MR = 8;
+    constexpr size_t NR = 32;
+    __m512i acc[MR][2];
+    for (size_t i = 0; i < MR; ++i) {
+        acc[i][0] = _mm512_setzero_si512();
+        acc[i][1] = _mm512_setzero_si512();
+    }
+
+    for (size_t s = 0; s < steps; ++s) {
+        __m512i b0 = _mm512_loadu_si512(b);
+        __m512i b1 = _mm512_loadu_si512(b + 32);
+        for (size_t i = 0; i < MR; ++i) {
+            int32_t pair;
+            __builtin_memcpy(&pair, a + 2 * i, sizeof(pair));
+            __m512i ai = _mm512_set1_epi32(pair);
+            acc[i][0] = _mm512_add_epi32(acc[i][0], _mm512_madd_epi16(ai, b0));
+            acc[i][1] = _mm512_add_epi32(acc[i][1], _mm512_madd_epi16(ai, b1));
+        }
+        a += 2 * MR;
+        b += 2 * NR;
+    }
+
+    for (size_t i = 0; i < MR; ++i) {
+        int32_t* row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm512_add_epi32(acc[i][0], _mm512_loadu_si512(row));
+            acc[i][1] = _mm512_add_epi32(acc[i][1], _mm512_loadu_si512(row + 16));
+        }
+        _mm512_storeu_si512(row, acc[i][0]);
+        _mm512_storeu_si512(row + 16, acc[i][1]);
+    }
+}
+
+}
+
+const GemmKernel<int8_t> gemm_kernel_avx512_i8 = {"avx512", 8, 32, kernel_i8};
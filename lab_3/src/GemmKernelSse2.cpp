@@ -0,0 +1,76 @@
+#include <immintrin.h>
+
+#include "../include/GemmKernels.h"
+
+namespace {
+
+// 4x4 doubles: 8 xmm accumulators.
+void kernel_f64(size_t kc, const double* a, const double* b, double* c, size_t ldc, bool accumulate) {
+    constexpr size_t MR = 4;
+    constexpr size_t NR = 4;
+    __m128d acc[MR][2];
+    for (size_t i = 0; i < MR; ++i) {
+        acc[i][0] = _mm_setzero_pd();
+        acc[i][1] = _mm_setzero_pd();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        __m128d b0 = _mm_loadu_pd(b);
+        __m128d b1 = _mm_loadu_pd(b + 2);
+        for (size_t i = 0; i < MR; ++i) {
+            __m128d ai = _mm_set1_pd(a[i]);
+            acc[i][0] = _mm_add_pd(acc[i][0], _mm_mul_pd(ai, b0));
+            acc[i][1] = _mm_add_pd(acc[i][1], _mm_mul_pd(ai, b1));
+        }
+        a += MR;
+        b += NR;
+    }
+
+    for (size_t i = 0; i < MR; ++i) {
+        double* row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm_add_pd(acc[i][0], _mm_loadu_pd(row));
+            acc[i][1] = _mm_add_pd(acc[i][1], _mm_loadu_pd(row + 2));
+        }
+        _mm_storeu_pd(row, acc[i][0]);
+        _mm_storeu_pd(row + 2, acc[i][1]);
+    }
+}
+
+// 4x8 floats: 8 xmm accumulators.
+void kernel_f32(size_t kc, const float* a, const float* b, float* c, size_t ldc, bool accumulate) {
+    constexpr size_t MR = 4;
+    constexpr size_t NR = 8;
+    __m128 acc[MR][2];
+    for (size_t i = 0; i < MR; ++i) {
+        acc[i][0] = _mm_setzero_ps();
+        acc[i][1] = _mm_setzero_ps();
+    }
+
+    for (size_t p = 0; p < kc; ++p) {
+        __m128 b0 = _mm_loadu_ps(b);
+        __m128 b1 = _mm_loadu_ps(b + 4);
+        for (size_t i = 0; i < MR; ++i) {
+            __m128 ai = _mm_set1_ps(a[i]);
+            acc[i][0] = _mm_add_ps(acc[i][0], _mm_mul_ps(ai, b0));
+            acc[i][1] = _mm_add_ps(acc[i][1], _mm_mul_ps(ai, b1));
+        }
+        a += MR;
+        b += NR;
+    }
+
+    for (size_t i = 0; i < MR; ++i) {
+        float* row = c + i * ldc;
+        if (accumulate) {
+            acc[i][0] = _mm_add_ps(acc[i][0], _mm_loadu_ps(row));
+            acc[i][1] = _mm_add_ps(acc[i][1], _mm_loadu_ps(row + 4));
+        }
+        _mm_storeu_ps(row, acc[i][0]);
+        _mm_storeu_ps(row + 4, acc[i][1]);
+    }
+}
+
+}
+
+const GemmKernel<double> gemm_kernel_sse2_f64 = {"sse2", 4, 4, kernel_f64};
+const GemmKernel<float> gemm_kernel_sse2_f32 = {"sse2", 4, 8, kernel_f32};
@@ -0,0 +1,83 @@
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/MappedFile.h"
+
+MappedFile::MappedFile(const std::string& filename, Mode mode, bool populate) : _addr(nullptr), _length(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open file for mapping");
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) {
+        close(fd);
+        throw std::runtime_error("Failed to get file size");
+    }
+    _length = static_cast<size_t>(file_stat.st_size);
+
+    // mmap rejects zero-length mappings; an empty file is simply an empty view.
+    if (_length == 0) {
+        close(fd);
+        return;
+    }
+
+    int prot = mode == Mode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+    int flags = mode == Mode::ReadOnly ? MAP_SHARED : MAP_PRIVATE;
+    if (populate) {
+        flags |= MAP_POPULATE;
+    }
+
+    _addr = mmap(nullptr, _length, prot, flags, fd, 0);
+    close(fd);
+    if (_addr == MAP_FAILED) {
+        _addr = nullptr;
+        throw std::runtime_error("Failed to map file");
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (_addr != nullptr) {
+        // Nothing useful can be done about a failure here, and a destructor must not throw.
+        munmap(_addr, _length);
+    }
+}
+
+void MappedFile::advise(Access access) const {
+    if (_addr == nullptr) {
+        return;
+    }
+
+    int advice = MADV_NORMAL;
+    switch (access) {
+    case Access::Normal:
+        advice = MADV_NORMAL;
+        break;
+    case Access::Sequential:
+        advice = MADV_SEQUENTIAL;
+        break;
+    case Access::Random:
+        advice = MADV_RANDOM;
+        break;
+    case Access::WillNeed:
+        advice = MADV_WILLNEED;
+        break;
+    }
+    // Only a hint: if the kernel rejects it, the mapping still works, just without it.
+    madvise(_addr, _length, advice);
+}
+
+const char* MappedFile::data() const {
+    return static_cast<const char*>(_addr);
+}
+
+char* MappedFile::data() {
+    return static_cast<char*>(_addr);
+}
+
+size_t MappedFile::size() const {
+    return _length;
+}
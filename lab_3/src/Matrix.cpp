@@ -3,195 +3,410 @@
 #include <cmath>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/stat.h>
-#include <pthread.h>
+#include <algorithm>
 #include <chrono>
 #include <stdexcept>
 
 #include "../include/Matrix.h"
+#include "../include/MatrixFile.h"
+#include "../include/MatrixTiling.h"
+#include "../include/Gemm.h"
+#include "../include/Numa.h"
+#include "../include/Random.h"
+#include "../include/ThreadPool.h"
 #include "../include/check.hpp"
 
-Matrix::Matrix(size_t n) : _size(n), _data(n * n, 0.0) {}
+namespace {
+
+// First write to fresh storage: copies source (row stride source_ld) or zero-fills when it
+// is null. Large matrices are written tile by tile on the whole pool, in the grid products
+// on the whole pool use (see matrix_for_each_tile), unless NumaPlacement::Serial asks for
+// the old single-threaded fill.
+template <typename T>
+void first_touch(T* data, size_t rows, size_t cols, const T* source, size_t source_ld) {
+    auto fill = [&](size_t row, size_t col, size_t height, size_t width) {
+        for (size_t i = row; i < row + height; ++i) {
+            T* dst = data + i * cols + col;
+            if (source != nullptr) {
+                std::copy(source + i * source_ld + col, source + i * source_ld + col + width, dst);
+            } else {
+                std::fill(dst, dst + width, T(0));
+            }
+        }
+    };
+
+    if (matrix_touch_in_parallel(rows * cols * sizeof(T))) {
+        matrix_for_each_tile(rows, cols, ThreadPool::global().size(), fill);
+    } else {
+        fill(0, 0, rows, cols);
+    }
+}
+
+template <typename Reader>
+void with_matrix_file(const std::string& filename, Reader reader) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open file for reading");
+    }
+
+    try {
+        reader(fd, read_matrix_header(fd));
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+}
+
+template <typename T, typename Acc>
+void check_product_shapes(ConstMatrixView<T> a, ConstMatrixView<T> b, MatrixView<Acc> c) {
+    if (a.cols() != b.rows() || c.rows() != a.rows() || c.cols() != b.cols()) {
+        throw std::invalid_argument("Matrix dimensions must agree for multiplication");
+    }
+}
+
+}
+
+template <typename T>
+Matrix<T>::Matrix(size_t n) : Matrix(n, n) {}
+
+template <typename T>
+Matrix<T>::Matrix(size_t rows, size_t cols) : Matrix(rows, cols, uninitialized) {
+    first_touch<T>(_ptr, _rows, _cols, nullptr, _cols);
+}
+
+template <typename T>
+Matrix<T>::Matrix(size_t n, uninitialized_t) : Matrix(n, n, uninitialized) {}
+
+template <typename T>
+Matrix<T>::Matrix(size_t rows, size_t cols, uninitialized_t)
+    : _data(rows * cols), _rows(rows), _cols(cols), _ptr(_data.data()) {}
+
+template <typename T>
+Matrix<T>::Matrix(size_t n, std::type_identity_t<T> min_value, std::type_identity_t<T> max_value)
+    : Matrix(n, n, min_value, max_value) {}
 
-Matrix::Matrix(size_t n, double min_value, double max_value) : _size(n), _data(n * n) {
+template <typename T>
+Matrix<T>::Matrix(size_t rows, size_t cols, std::type_identity_t<T> min_value, std::type_identity_t<T> max_value)
+    : Matrix(rows, cols, uninitialized) {
     if (min_value > max_value) {
         throw std::invalid_argument("min_value must be less than or equal to max_value");
     }
     fill_random(min_value, max_value);
 }
 
-Matrix::Matrix(const std::vector<double>& matrix) {
+template <typename T>
+Matrix<T>::Matrix(const std::vector<T>& matrix) {
     double size_d = std::sqrt(matrix.size());
     if (std::floor(size_d) != size_d) {
         throw std::invalid_argument("Input vector length must be a perfect square");
     }
-    _size = static_cast<size_t>(size_d);
-    _data = matrix;
+    _rows = _cols = static_cast<size_t>(size_d);
+    _data.resize(matrix.size());
+    _ptr = _data.data();
+    first_touch(_ptr, _rows, _cols, matrix.data(), _cols);
 }
 
-void Matrix::fill_random(double min_val, double max_val) {
-    if (min_val > max_val) {
-        throw std::invalid_argument("min_val must be less than or equal to max_val");
-    }
+template <typename T>
+Matrix<T>::Matrix(ConstMatrixView<T> view)
+    : _data(view.rows() * view.cols()), _rows(view.rows()), _cols(view.cols()), _ptr(_data.data()) {
+    first_touch(_ptr, _rows, _cols, view.data(), view.ld());
+}
 
-    double range = max_val - min_val;
-    for (size_t i = 0; i < _size * _size; ++i) {
-        _data[i] = min_val + (static_cast<double>(std::rand()) / RAND_MAX) * range;
-    }
+template <typename T>
+Matrix<T>::Matrix(const Matrix& other)
+    : _data(other._rows * other._cols), _rows(other._rows), _cols(other._cols), _ptr(_data.data()) {
+    first_touch<T>(_ptr, _rows, _cols, other._ptr, other._cols);
 }
 
-void Matrix::write_to_file(const std::string& filename) const {
-    int fd = check(open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644));
-    if (fd == -1) {
-        throw std::runtime_error("Failed to open file for writing");
-    }
+template <typename T>
+Matrix<T>::Matrix(Matrix&& other) noexcept
+    : _data(std::move(other._data)), _rows(other._rows), _cols(other._cols),
+      _mapping(std::move(other._mapping)), _ptr(other._ptr) {
+    other._rows = other._cols = 0;
+    other._ptr = other._data.data();
+}
 
-    ssize_t bytes_written = check(write(fd, _data.data(), _size * _size * sizeof(double)));
-    if (bytes_written == -1 || static_cast<size_t>(bytes_written) != _size * _size * sizeof(double)) {
-        close(fd);
-        throw std::runtime_error("Failed to write matrix to file");
-    }
-    close(fd);
+template <typename T>
+Matrix<T>& Matrix<T>::operator=(Matrix other) noexcept {
+    std::swap(_data, other._data);
+    std::swap(_rows, other._rows);
+    std::swap(_cols, other._cols);
+    std::swap(_mapping, other._mapping);
+    std::swap(_ptr, other._ptr);
+    return *this;
 }
 
-Matrix Matrix::read_from_file(const std::string& filename) {
-    int fd = check(open(filename.c_str(), O_RDONLY));
-    if (fd == -1) {
-        throw std::runtime_error("Failed to open file for reading");
-    }
+template <typename T>
+void Matrix<T>::fill_random(std::type_identity_t<T> min_val, std::type_identity_t<T> max_val) {
+    fill_random(min_val, max_val, random_next_seed());
+}
 
-    struct stat file_stat;
-    if (fstat(fd, &file_stat) == -1) {
-        close(fd);
-        throw std::runtime_error("Failed to get file size");
+template <typename T>
+void Matrix<T>::fill_random(std::type_identity_t<T> min_val, std::type_identity_t<T> max_val, uint64_t seed) {
+    if (min_val > max_val) {
+        throw std::invalid_argument("min_val must be less than or equal to max_val");
     }
 
-    off_t file_size = file_stat.st_size;
-    size_t matrix_size = static_cast<size_t>(std::sqrt(file_size / sizeof(double)));
+    T* values = data();
+    auto fill = [&](size_t row, size_t col, size_t height, size_t width) {
+        for (size_t i = row; i < row + height; ++i) {
+            random_uniform<T>(seed, i * _cols + col, width, min_val, max_val, values + i * _cols + col);
+        }
+    };
 
-    if (matrix_size * matrix_size * sizeof(double) != static_cast<size_t>(file_size)) {
-        close(fd);
-        throw std::runtime_error("Invalid file size for square matrix");
+    if (matrix_touch_in_parallel(_rows * _cols * sizeof(T))) {
+        matrix_for_each_tile(_rows, _cols, ThreadPool::global().size(), fill);
+    } else {
+        fill(0, 0, _rows, _cols);
     }
+}
 
-    Matrix result(matrix_size);
-    ssize_t bytes_read = check(read(fd, result._data.data(), file_size));
-    if (bytes_read == -1 || static_cast<size_t>(bytes_read) != file_size) {
-        close(fd);
-        throw std::runtime_error("Failed to read matrix from file");
+template <typename T>
+void Matrix<T>::write_to_file(const std::string& filename, DType dtype, bool with_checksum) const {
+    write_to_file(filename, view(), dtype, with_checksum);
+}
+
+template <typename T>
+void Matrix<T>::write_to_file(const std::string& filename, ConstMatrixView<T> view, DType dtype, bool with_checksum) {
+    write_matrix_file(filename, view.rows(), view.cols(), view.data(), view.ld(), dtype, with_checksum);
+}
+
+template <typename T>
+Matrix<T> Matrix<T>::read_from_file(const std::string& filename) {
+    Matrix result(0);
+    with_matrix_file(filename, [&](int fd, const MatrixFileInfo& info) {
+        result = Matrix(info.rows, info.cols, uninitialized);
+        read_matrix_payload(fd, info, result._ptr, result._cols);
+    });
+    return result;
+}
+
+template <typename T>
+void Matrix<T>::read_from_file(const std::string& filename, MatrixView<T> out) {
+    with_matrix_file(filename, [&](int fd, const MatrixFileInfo& info) {
+        if (info.rows != out.rows() || info.cols != out.cols()) {
+            throw std::invalid_argument("Matrix in file does not match the target view shape");
+        }
+        read_matrix_payload(fd, info, out.data(), out.ld());
+    });
+}
+
+template <typename T>
+Matrix<T> Matrix<T>::open_mapped(const std::string& filename, MappedFile::Mode mode, bool populate,
+                                 MappedFile::Access access) {
+    auto mapping = std::make_shared<MappedFile>(filename, mode, populate);
+    MatrixFileInfo info = parse_matrix_header(mapping->data(), mapping->size(), mapping->size());
+    if (info.dtype != dtype_of<T>()) {
+        throw std::runtime_error("Matrix file dtype does not match the element type");
     }
+    mapping->advise(access);
 
-    close(fd);
+    Matrix result(0);
+    result._rows = info.rows;
+    result._cols = info.cols;
+    result._ptr = reinterpret_cast<T*>(mapping->data() + info.payload_offset);
+    result._mapping = std::move(mapping);
     return result;
 }
 
-void Matrix::print() const {
-    std::cout << "Matrix " << _size << "x" << _size << ":\n";
-    for (size_t i = 0; i < _size; ++i) {
-        for (size_t j = 0; j < _size; ++j) {
-            std::cout << _data[i * _size + j] << "\t";
+template <typename T>
+void Matrix<T>::print() const {
+    std::cout << "Matrix " << _rows << "x" << _cols << ":\n";
+    for (size_t i = 0; i < _rows; ++i) {
+        for (size_t j = 0; j < _cols; ++j) {
+            // Unary plus prints int8_t as a number rather than a character.
+            std::cout << +_ptr[i * _cols + j] << "\t";
         }
         std::cout << "\n";
     }
 }
 
-size_t Matrix::size() const {
-    return _size;
+template <typename T>
+size_t Matrix<T>::size() const {
+    return _rows;
+}
+
+template <typename T>
+size_t Matrix<T>::rows() const {
+    return _rows;
+}
+
+template <typename T>
+size_t Matrix<T>::cols() const {
+    return _cols;
+}
+
+template <typename T>
+bool Matrix<T>::is_mapped() const {
+    return _mapping != nullptr;
 }
 
-double Matrix::operator()(size_t i, size_t j) const {
-    if (i >= _size || j >= _size) {
+template <typename T>
+const T* Matrix<T>::data() const {
+    return _ptr;
+}
+
+template <typename T>
+T* Matrix<T>::data() {
+    return _ptr;
+}
+
+template <typename T>
+ConstMatrixView<T> Matrix<T>::view() const {
+    return ConstMatrixView<T>(_ptr, _rows, _cols);
+}
+
+template <typename T>
+MatrixView<T> Matrix<T>::view() {
+    return MatrixView<T>(_ptr, _rows, _cols);
+}
+
+template <typename T>
+ConstMatrixView<T> Matrix<T>::block(size_t row, size_t col, size_t rows, size_t cols) const {
+    return view().block(row, col, rows, cols);
+}
+
+template <typename T>
+MatrixView<T> Matrix<T>::block(size_t row, size_t col, size_t rows, size_t cols) {
+    return view().block(row, col, rows, cols);
+}
+
+template <typename T>
+T Matrix<T>::operator()(size_t i, size_t j) const {
+    if (i >= _rows || j >= _cols) {
         throw std::out_of_range("Matrix indices out of range");
     }
-    return _data[i * _size + j];
+    return _ptr[i * _cols + j];
 }
 
-double& Matrix::operator()(size_t i, size_t j) {
-    if (i >= _size || j >= _size) {
+template <typename T>
+T& Matrix<T>::operator()(size_t i, size_t j) {
+    if (i >= _rows || j >= _cols) {
         throw std::out_of_range("Matrix indices out of range");
     }
-    return _data[i * _size + j];
+    return _ptr[i * _cols + j];
 }
 
-Matrix Matrix::multiply(const Matrix& other) const {
-    if (_size != other._size) {
+template <typename T>
+Matrix<gemm_acc_t<T>> Matrix<T>::multiply(const Matrix& other) const {
+    if (_cols != other._rows) {
         throw std::invalid_argument("Matrix dimensions must agree for multiplication");
     }
 
-    Matrix result(_size);
-    for (size_t i = 0; i < _size; ++i) {
-        for (size_t j = 0; j < _size; ++j) {
-            double sum = 0.0;
-            for (size_t k = 0; k < _size; ++k) {
-                sum += (*this)(i, k) * other(k, j);
-            }
-            result(i, j) = sum;
-        }
-    }
+    Matrix<acc_type> result(_rows, other._cols, uninitialized);
+    multiply(view(), other.view(), result.view());
     return result;
 }
 
-void* Matrix::multiply_partial(void* arg) {
-    ThreadData* data = static_cast<ThreadData*>(arg);
-    const Matrix& mat1 = *(data->mat1);
-    const Matrix& mat2 = *(data->mat2);
-    Matrix& result = *(data->result);
-    size_t size = mat1.size();
+template <typename T>
+Matrix<gemm_acc_t<T>> Matrix<T>::multiply_reference(const Matrix& other) const {
+    if (_cols != other._rows) {
+        throw std::invalid_argument("Matrix dimensions must agree for multiplication");
+    }
 
-    for (size_t i = data->start_row; i < data->end_row; ++i) {
-        for (size_t j = 0; j < size; ++j) {
-            double sum = 0.0;
-            for (size_t k = 0; k < size; ++k) {
-                sum += mat1(i, k) * mat2(k, j);
+    Matrix<acc_type> result(_rows, other._cols, uninitialized);
+    for (size_t i = 0; i < _rows; ++i) {
+        for (size_t j = 0; j < other._cols; ++j) {
+            acc_type sum = 0;
+            for (size_t k = 0; k < _cols; ++k) {
+                sum += static_cast<acc_type>((*this)(i, k)) * static_cast<acc_type>(other(k, j));
             }
             result(i, j) = sum;
         }
     }
-
-    return nullptr;
+    return result;
 }
 
-Matrix Matrix::parallel_multiply(const Matrix& other, size_t num_threads) const {
-    if (_size != other._size) {
+template <typename T>
+Matrix<gemm_acc_t<T>> Matrix<T>::parallel_multiply(const Matrix& other, size_t num_threads) const {
+    if (_cols != other._rows) {
         throw std::invalid_argument("Matrix dimensions must agree for multiplication");
     }
-    if (num_threads == 0) {
-        throw std::invalid_argument("Number of threads must be positive");
-    }
 
-    Matrix result(_size);
-    if (_size == 0) {
-        return result;
-    }
+    Matrix<acc_type> result(_rows, other._cols, uninitialized);
+    parallel_multiply(view(), other.view(), result.view(), num_threads);
+    return result;
+}
 
-    num_threads = std::min(num_threads, _size);
-    std::vector<pthread_t> threads(num_threads);
-    std::vector<ThreadData> thread_data(num_threads);
+template <typename T>
+void Matrix<T>::multiply(ConstMatrixView<T> a, ConstMatrixView<T> b, MatrixView<acc_type> c) {
+    check_product_shapes(a, b, c);
+    gemm_blocked(a.rows(), b.cols(), a.cols(), a.data(), a.ld(), b.data(), b.ld(), c.data(), c.ld());
+}
 
-    size_t rows_per_thread = _size / num_threads;
-    size_t remainder = _size % num_threads;
-    size_t start_row = 0;
+template <typename T>
+void Matrix<T>::parallel_multiply(ConstMatrixView<T> a, ConstMatrixView<T> b, MatrixView<acc_type> c,
+                                  size_t num_threads) {
+    check_product_shapes(a, b, c);
+    if (c.rows() == 0 || c.cols() == 0) {
+        return;
+    }
 
-    for (size_t i = 0; i < num_threads; ++i) {
-        size_t end_row = start_row + rows_per_thread + (i < remainder ? 1 : 0);
+    ThreadPool& pool = ThreadPool::global();
+    size_t workers = num_threads == 0 ? pool.size() : std::min(num_threads, pool.size());
+    matrix_for_each_tile(c.rows(), c.cols(), workers, [&](size_t row, size_t col, size_t rows, size_t cols) {
+        gemm_blocked(rows, cols, a.cols(),
+                     a.data() + row * a.ld(), a.ld(),
+                     b.data() + col, b.ld(),
+                     c.data() + row * c.ld() + col, c.ld());
+    });
+}
 
-        thread_data[i] = {this, &other, &result, start_row, end_row};
+template <typename T>
+void Matrix<T>::gemm(std::type_identity_t<T> alpha, ConstMatrixView<T> a, ConstMatrixView<T> b,
+                     std::type_identity_t<T> beta, MatrixView<T> c, size_t num_threads)
+    requires std::is_same_v<T, acc_type> {
+    check_product_shapes(a, b, c);
+    if (c.rows() == 0 || c.cols() == 0) {
+        return;
+    }
 
-        if (check_result(pthread_create(&threads[i], nullptr, multiply_partial, &thread_data[i]))) {
-            for (size_t j = 0; j < i; ++j) {
-                check_result(pthread_join(threads[j], nullptr));
-            }
-            throw std::runtime_error("Failed to create thread");
-        }
+    ThreadPool& pool = ThreadPool::global();
+    size_t workers = num_threads == 0 ? pool.size() : std::min(num_threads, pool.size());
+    matrix_for_each_tile(c.rows(), c.cols(), workers, [&](size_t row, size_t col, size_t rows, size_t cols) {
+        ::gemm(rows, cols, a.cols(), alpha,
+               a.data() + row * a.ld(), a.ld(),
+               b.data() + col, b.ld(),
+               beta, c.data() + row * c.ld() + col, c.ld());
+    });
+}
 
-        start_row = end_row;
+template <typename T>
+Matrix<T>& Matrix<T>::gemm(std::type_identity_t<T> alpha, const Matrix& a, const Matrix& b,
+                           std::type_identity_t<T> beta, size_t num_threads)
+    requires std::is_same_v<T, acc_type> {
+    if (a.data() == data() || b.data() == data()) {
+        // c must not overlap its operands; multiply into a copy instead.
+        Matrix<T> c(*this);
+        gemm(alpha, a.view(), b.view(), beta, c.view(), num_threads);
+        *this = std::move(c);
+    } else {
+        gemm(alpha, a.view(), b.view(), beta, view(), num_threads);
     }
+    return *this;
+}
 
-    for (auto& thread : threads) {
-        if (check_result(pthread_join(thread, nullptr))) {
-            throw std::runtime_error("Failed to join thread");
-        }
+template <typename T>
+Matrix<T> Matrix<T>::strassen_multiply(const Matrix& other, size_t crossover) const
+    requires std::is_floating_point_v<T> {
+    if (_cols != other._rows) {
+        throw std::invalid_argument("Matrix dimensions must agree for multiplication");
     }
 
+    Matrix result(_rows, other._cols, uninitialized);
+    strassen_multiply(view(), other.view(), result.view(), crossover);
     return result;
-}
\ No newline at end of file
+}
+
+template <typename T>
+void Matrix<T>::strassen_multiply(ConstMatrixView<T> a, ConstMatrixView<T> b, MatrixView<T> c, size_t crossover)
+    requires std::is_floating_point_v<T> {
+    check_product_shapes(a, b, c);
+    gemm_strassen(a.rows(), b.cols(), a.cols(), a.data(), a.ld(), b.data(), b.ld(), c.data(), c.ld(), crossover);
+}
+
+template class Matrix<double>;
+template class Matrix<float>;
+template class Matrix<int8_t>;
+template class Matrix<int32_t>;
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "../include/MatrixBatch.h"
+#include "../include/MatrixTiling.h"
+#include "../include/Random.h"
+#include "../include/ThreadPool.h"
+
+namespace {
+
+constexpr size_t CHUNK = 1 << 16;
+
+// Runs fn(first, count) over [0, total) elements, in CHUNK-sized pieces on the pool when the
+// batch is large enough to be worth spreading (see matrix_touch_in_parallel).
+template <typename T, typename Fn>
+void for_each_chunk(size_t total, Fn fn) {
+    if (!matrix_touch_in_parallel(total * sizeof(T))) {
+        fn(0, total);
+        return;
+    }
+    ThreadPool::global().parallel_for((total + CHUNK - 1) / CHUNK, [&](size_t c) {
+        fn(c * CHUNK, std::min(CHUNK, total - c * CHUNK));
+    });
+}
+
+}
+
+template <typename T>
+MatrixBatch<T>::MatrixBatch(size_t count, size_t rows, size_t cols, uninitialized_t)
+    : _data(count * rows * cols), _count(count), _rows(rows), _cols(cols) {}
+
+template <typename T>
+MatrixBatch<T>::MatrixBatch(size_t count, size_t rows, size_t cols) : MatrixBatch(count, rows, cols, uninitialized) {
+    T* values = data();
+    for_each_chunk<T>(_data.size(), [&](size_t first, size_t n) {
+        std::fill(values + first, values + first + n, T(0));
+    });
+}
+
+template <typename T>
+void MatrixBatch<T>::fill_random(std::type_identity_t<T> min_val, std::type_identity_t<T> max_val) {
+    fill_random(min_val, max_val, random_next_seed());
+}
+
+template <typename T>
+void MatrixBatch<T>::fill_random(std::type_identity_t<T> min_val, std::type_identity_t<T> max_val, uint64_t seed) {
+    if (min_val > max_val) {
+        throw std::invalid_argument("min_val must be less than or equal to max_val");
+    }
+
+    T* values = data();
+    for_each_chunk<T>(_data.size(), [&](size_t first, size_t n) {
+        random_uniform<T>(seed, first, n, min_val, max_val, values + first);
+    });
+}
+
+template <typename T>
+MatrixBatch<typename MatrixBatch<T>::acc_type> MatrixBatch<T>::multiply(const MatrixBatch& other,
+                                                                         size_t num_threads) const {
+    if (_count != other._count || _cols != other._rows) {
+        throw std::invalid_argument("Batch sizes and matrix dimensions must agree for multiplication");
+    }
+
+    MatrixBatch<acc_type> result(_count, _rows, other._cols, uninitialized);
+    gemm_batched(_count, _rows, other._cols, _cols, data(), other.data(), result.data(), num_threads);
+    return result;
+}
+
+template class MatrixBatch<double>;
+template class MatrixBatch<float>;
+template class MatrixBatch<int8_t>;
+template class MatrixBatch<int32_t>;
@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/MatrixFile.h"
+
+namespace {
+
+constexpr char MAGIC[8] = {'S', 'P', 'M', 'A', 'T', 'R', 'I', 'X'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Elements converted per chunk when the stored dtype differs from double.
+constexpr size_t CONVERT_CHUNK = 1 << 16;
+
+const std::array<uint32_t, 256> CRC_TABLE = [] {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}();
+
+void read_fully(int fd, void* buffer, size_t size, off_t offset) {
+    char* out = static_cast<char*>(buffer);
+    while (size > 0) {
+        ssize_t bytes_read = pread(fd, out, size, offset);
+        if (bytes_read <= 0) {
+            throw std::runtime_error("Failed to read matrix from file");
+        }
+        out += bytes_read;
+        size -= bytes_read;
+        offset += bytes_read;
+    }
+}
+
+void write_fully(int fd, const void* buffer, size_t size, off_t offset) {
+    const char* in = static_cast<const char*>(buffer);
+    while (size > 0) {
+        ssize_t bytes_written = pwrite(fd, in, size, offset);
+        if (bytes_written <= 0) {
+            throw std::runtime_error("Failed to write matrix to file");
+        }
+        in += bytes_written;
+        size -= bytes_written;
+        offset += bytes_written;
+    }
+}
+
+MatrixFileHeader make_header(size_t rows, size_t cols, DType dtype) {
+    MatrixFileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.rows = rows;
+    header.cols = cols;
+    header.dtype = static_cast<uint32_t>(dtype);
+    header.payload_offset = MATRIX_FILE_ALIGNMENT;
+    return header;
+}
+
+}
+
+size_t dtype_size(DType dtype) {
+    switch (dtype) {
+    case DType::Float64:
+        return sizeof(double);
+    case DType::Float32:
+        return sizeof(float);
+    case DType::Int8:
+        return sizeof(int8_t);
+    case DType::Int32:
+        return sizeof(int32_t);
+    }
+    throw std::invalid_argument("Unknown matrix dtype");
+}
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = CRC_TABLE[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+MatrixFileInfo parse_matrix_header(const char* data, size_t available, size_t file_size) {
+    if (available < sizeof(MatrixFileHeader) || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        size_t n = static_cast<size_t>(std::sqrt(file_size / sizeof(double)));
+        if (n * n * sizeof(double) != file_size) {
+            throw std::runtime_error("Invalid file size for square matrix");
+        }
+        return {n, n, DType::Float64, 0, true, false, 0};
+    }
+
+    MatrixFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.byte_order != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Matrix file was written with a different byte order");
+    }
+    if (header.version != VERSION) {
+        throw std::runtime_error("Unsupported matrix file version");
+    }
+    if (header.dtype < static_cast<uint32_t>(DType::Float64) || header.dtype > static_cast<uint32_t>(DType::Int32)) {
+        throw std::runtime_error("Unsupported matrix dtype");
+    }
+
+    MatrixFileInfo info{header.rows, header.cols, static_cast<DType>(header.dtype), header.payload_offset,
+                        false, (header.flags & MATRIX_FILE_CHECKSUM) != 0, header.checksum};
+    // open_mapped hands out the payload in place, so it has to keep the page alignment the
+    // format promises; anything else would give the kernels a misaligned pointer.
+    if (info.payload_offset % MATRIX_FILE_ALIGNMENT != 0) {
+        throw std::runtime_error("Matrix file payload is not page aligned");
+    }
+    size_t element_size = dtype_size(info.dtype);
+    if (info.payload_offset < sizeof(MatrixFileHeader) || info.payload_offset > file_size ||
+        (info.cols != 0 && info.rows > (file_size - info.payload_offset) / element_size / info.cols) ||
+        info.payload_offset + info.rows * info.cols * element_size != file_size) {
+        throw std::runtime_error("Matrix file size does not match its header");
+    }
+    return info;
+}
+
+MatrixFileInfo read_matrix_header(int fd) {
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) {
+        throw std::runtime_error("Failed to get file size");
+    }
+    size_t file_size = static_cast<size_t>(file_stat.st_size);
+
+    char buffer[sizeof(MatrixFileHeader)];
+    size_t available = std::min(file_size, sizeof(buffer));
+    read_fully(fd, buffer, available, 0);
+    return parse_matrix_header(buffer, available, file_size);
+}
+
+namespace {
+
+// Elements are converted through a bounce buffer of CONVERT_CHUNK, or written directly
+// when the stored type matches T.
+template <typename Stored, typename T>
+void write_runs(int fd, size_t runs, size_t run_length, const T* values, size_t ld,
+                bool with_checksum, uint32_t& checksum) {
+    off_t offset = MATRIX_FILE_ALIGNMENT;
+    std::vector<Stored> chunk(std::is_same_v<Stored, T> ? 0 : std::min(run_length, CONVERT_CHUNK));
+
+    for (size_t run = 0; run < runs; ++run) {
+        const T* source = values + run * ld;
+        if constexpr (std::is_same_v<Stored, T>) {
+            write_fully(fd, source, run_length * sizeof(T), offset);
+            if (with_checksum) {
+                checksum = crc32(source, run_length * sizeof(T), checksum);
+            }
+            offset += run_length * sizeof(T);
+        } else {
+            for (size_t start = 0; start < run_length; start += chunk.size()) {
+                size_t length = std::min(chunk.size(), run_length - start);
+                std::transform(source + start, source + start + length, chunk.begin(),
+                               [](T value) { return static_cast<Stored>(value); });
+                write_fully(fd, chunk.data(), length * sizeof(Stored), offset);
+                if (with_checksum) {
+                    checksum = crc32(chunk.data(), length * sizeof(Stored), checksum);
+                }
+                offset += length * sizeof(Stored);
+            }
+        }
+    }
+}
+
+template <typename Stored, typename T>
+void read_runs(int fd, const MatrixFileInfo& info, size_t runs, size_t run_length, T* out, size_t ld,
+               uint32_t& checksum) {
+    off_t offset = info.payload_offset;
+    std::vector<Stored> chunk(std::is_same_v<Stored, T> ? 0 : std::min(run_length, CONVERT_CHUNK));
+
+    for (size_t run = 0; run < runs; ++run) {
+        T* target = out + run * ld;
+        if constexpr (std::is_same_v<Stored, T>) {
+            read_fully(fd, target, run_length * sizeof(T), offset);
+            if (info.has_checksum) {
+                checksum = crc32(target, run_length * sizeof(T), checksum);
+            }
+            offset += run_length * sizeof(T);
+        } else {
+            for (size_t start = 0; start < run_length; start += chunk.size()) {
+                size_t length = std::min(chunk.size(), run_length - start);
+                read_fully(fd, chunk.data(), length * sizeof(Stored), offset);
+                if (info.has_checksum) {
+                    checksum = crc32(chunk.data(), length * sizeof(Stored), checksum);
+                }
+                std::transform(chunk.begin(), chunk.begin() + length, target + start,
+                               [](Stored value) { return static_cast<T>(value); });
+                offset += length * sizeof(Stored);
+            }
+        }
+    }
+}
+
+}
+
+template <typename T>
+void write_matrix_file(const std::string& filename, size_t rows, size_t cols, const T* values,
+                       size_t ld, DType dtype, bool with_checksum) {
+    int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open file for writing");
+    }
+
+    try {
+        // A contiguous matrix is written as one run; a strided view one row at a time.
+        size_t runs = ld == cols ? 1 : rows;
+        size_t run_length = ld == cols ? rows * cols : cols;
+        uint32_t checksum = 0;
+
+        switch (dtype) {
+        case DType::Float64:
+            write_runs<double>(fd, runs, run_length, values, ld, with_checksum, checksum);
+            break;
+        case DType::Float32:
+            write_runs<float>(fd, runs, run_length, values, ld, with_checksum, checksum);
+            break;
+        case DType::Int8:
+            write_runs<int8_t>(fd, runs, run_length, values, ld, with_checksum, checksum);
+            break;
+        case DType::Int32:
+            write_runs<int32_t>(fd, runs, run_length, values, ld, with_checksum, checksum);
+            break;
+        }
+
+        // The header goes last so its checksum covers what actually reached the file;
+        // the gap up to the payload is left as a hole and reads back as zeros.
+        MatrixFileHeader header = make_header(rows, cols, dtype);
+        header.flags = with_checksum ? MATRIX_FILE_CHECKSUM : 0;
+        header.checksum = checksum;
+        write_fully(fd, &header, sizeof(header), 0);
+        if (rows * cols == 0 && ftruncate(fd, MATRIX_FILE_ALIGNMENT) == -1) {
+            throw std::runtime_error("Failed to write matrix to file");
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+}
+
+template <typename T>
+void read_matrix_payload(int fd, const MatrixFileInfo& info, T* out, size_t ld) {
+    size_t runs = ld == info.cols ? 1 : info.rows;
+    size_t run_length = ld == info.cols ? info.rows * info.cols : info.cols;
+    uint32_t checksum = 0;
+
+    switch (info.dtype) {
+    case DType::Float64:
+        read_runs<double>(fd, info, runs, run_length, out, ld, checksum);
+        break;
+    case DType::Float32:
+        read_runs<float>(fd, info, runs, run_length, out, ld, checksum);
+        break;
+    case DType::Int8:
+        read_runs<int8_t>(fd, info, runs, run_length, out, ld, checksum);
+        break;
+    case DType::Int32:
+        read_runs<int32_t>(fd, info, runs, run_length, out, ld, checksum);
+        break;
+    }
+
+    if (info.has_checksum && checksum != info.checksum) {
+        throw std::runtime_error("Matrix file checksum mismatch");
+    }
+}
+
+namespace {
+
+void check_block(const MatrixFileInfo& info, size_t row, size_t col, size_t rows, size_t cols) {
+    if (row > info.rows || col > info.cols || rows > info.rows - row || cols > info.cols - col) {
+        throw std::out_of_range("Matrix file block out of range");
+    }
+}
+
+// Blocks go to and from the file in one run per row, or a single run when they span whole
+// rows; other dtypes are converted through a CONVERT_CHUNK bounce buffer as above.
+template <typename Stored, typename T>
+void read_block_runs(int fd, const MatrixFileInfo& info, size_t row, size_t col, size_t rows, size_t cols,
+                     T* out, size_t ld) {
+    bool whole_rows = col == 0 && cols == info.cols && ld == cols;
+    size_t runs = whole_rows ? 1 : rows;
+    size_t run_length = whole_rows ? rows * cols : cols;
+    std::vector<Stored> chunk(std::is_same_v<Stored, T> ? 0 : std::min(run_length, CONVERT_CHUNK));
+
+    for (size_t run = 0; run < runs; ++run) {
+        off_t offset = info.payload_offset + ((row + run) * info.cols + col) * sizeof(Stored);
+        T* target = out + run * ld;
+        if constexpr (std::is_same_v<Stored, T>) {
+            read_fully(fd, target, run_length * sizeof(T), offset);
+        } else {
+            for (size_t start = 0; start < run_length; start += chunk.size()) {
+                size_t length = std::min(chunk.size(), run_length - start);
+                read_fully(fd, chunk.data(), length * sizeof(Stored), offset + start * sizeof(Stored));
+                std::transform(chunk.begin(), chunk.begin() + length, target + start,
+                               [](Stored value) { return static_cast<T>(value); });
+            }
+        }
+    }
+}
+
+template <typename Stored, typename T>
+void write_block_runs(int fd, const MatrixFileInfo& info, size_t row, size_t col, size_t rows, size_t cols,
+                      const T* values, size_t ld) {
+    bool whole_rows = col == 0 && cols == info.cols && ld == cols;
+    size_t runs = whole_rows ? 1 : rows;
+    size_t run_length = whole_rows ? rows * cols : cols;
+    std::vector<Stored> chunk(std::is_same_v<Stored, T> ? 0 : std::min(run_length, CONVERT_CHUNK));
+
+    for (size_t run = 0; run < runs; ++run) {
+        off_t offset = info.payload_offset + ((row + run) * info.cols + col) * sizeof(Stored);
+        const T* source = values + run * ld;
+        if constexpr (std::is_same_v<Stored, T>) {
+            write_fully(fd, source, run_length * sizeof(T), offset);
+        } else {
+            for (size_t start = 0; start < run_length; start += chunk.size()) {
+                size_t length = std::min(chunk.size(), run_length - start);
+                std::transform(source + start, source + start + length, chunk.begin(),
+                               [](T value) { return static_cast<Stored>(value); });
+                write_fully(fd, chunk.data(), length * sizeof(Stored), offset + start * sizeof(Stored));
+            }
+        }
+    }
+}
+
+}
+
+template <typename T>
+void read_matrix_block(int fd, const MatrixFileInfo& info, size_t row, size_t col, size_t rows, size_t cols,
+                       T* out, size_t ld) {
+    check_block(info, row, col, rows, cols);
+    switch (info.dtype) {
+    case DType::Float64:
+        read_block_runs<double>(fd, info, row, col, rows, cols, out, ld);
+        break;
+    case DType::Float32:
+        read_block_runs<float>(fd, info, row, col, rows, cols, out, ld);
+        break;
+    case DType::Int8:
+        read_block_runs<int8_t>(fd, info, row, col, rows, cols, out, ld);
+        break;
+    case DType::Int32:
+        read_block_runs<int32_t>(fd, info, row, col, rows, cols, out, ld);
+        break;
+    }
+}
+
+template <typename T>
+void write_matrix_block(int fd, const MatrixFileInfo& info, size_t row, size_t col, size_t rows, size_t cols,
+                        const T* values, size_t ld) {
+    check_block(info, row, col, rows, cols);
+    switch (info.dtype) {
+    case DType::Float64:
+        write_block_runs<double>(fd, info, row, col, rows, cols, values, ld);
+        break;
+    case DType::Float32:
+        write_block_runs<float>(fd, info, row, col, rows, cols, values, ld);
+        break;
+    case DType::Int8:
+        write_block_runs<int8_t>(fd, info, row, col, rows, cols, values, ld);
+        break;
+    case DType::Int32:
+        write_block_runs<int32_t>(fd, info, row, col, rows, cols, values, ld);
+        break;
+    }
+}
+
+MatrixFileInfo create_matrix_file(int fd, size_t rows, size_t cols, DType dtype) {
+    MatrixFileHeader header = make_header(rows, cols, dtype);
+    write_fully(fd, &header, sizeof(header), 0);
+    if (ftruncate(fd, MATRIX_FILE_ALIGNMENT + rows * cols * dtype_size(dtype)) == -1) {
+        throw std::runtime_error("Failed to resize matrix file");
+    }
+    return {rows, cols, dtype, MATRIX_FILE_ALIGNMENT, false, false, 0};
+}
+
+#define INSTANTIATE_MATRIX_FILE(T)                                                                    \
+    template void write_matrix_file<T>(const std::string&, size_t, size_t, const T*, size_t, DType, bool); \
+    template void read_matrix_payload<T>(int, const MatrixFileInfo&, T*, size_t);                        \
+    template void read_matrix_block<T>(int, const MatrixFileInfo&, size_t, size_t, size_t, size_t, T*, size_t); \
+    template void write_matrix_block<T>(int, const MatrixFileInfo&, size_t, size_t, size_t, size_t, const T*, size_t);
+
+INSTANTIATE_MATRIX_FILE(float)
+INSTANTIATE_MATRIX_FILE(double)
+INSTANTIATE_MATRIX_FILE(int8_t)
+INSTANTIATE_MATRIX_FILE(int32_t)
@@ -0,0 +1,179 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "../include/Numa.h"
+
+namespace {
+
+constexpr size_t HEAP_ALIGNMENT = 64;
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+// Mappings of a huge page or more are rounded up to whole huge pages, so the tail can be
+// backed by one too; smaller ones to whole base pages.
+size_t mapping_length(size_t bytes) {
+    size_t unit = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return (bytes + unit - 1) / unit * unit;
+}
+
+// Online nodes as a bitmask in the layout mbind expects, parsed from a list like "0-1,3".
+std::vector<unsigned long> online_nodes() {
+    constexpr size_t BITS = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask;
+    std::ifstream file("/sys/devices/system/node/online");
+    std::string range;
+    while (std::getline(file, range, ',')) {
+        size_t dash = range.find('-');
+        unsigned long first = std::strtoul(range.c_str(), nullptr, 10);
+        unsigned long last = dash == std::string::npos ? first : std::strtoul(range.c_str() + dash + 1, nullptr, 10);
+        for (unsigned long node = first; node <= last; ++node) {
+            if (mask.size() <= node / BITS) {
+                mask.resize(node / BITS + 1, 0);
+            }
+            mask[node / BITS] |= 1ul << (node % BITS);
+        }
+    }
+    if (mask.empty()) {
+        mask.push_back(1);
+    }
+    return mask;
+}
+
+const std::vector<unsigned long>& node_mask() {
+    static const std::vector<unsigned long> mask = online_nodes();
+    return mask;
+}
+
+NumaPlacement placement_from_env() {
+    const char* value = std::getenv("MATRIX_NUMA");
+    if (value == nullptr) {
+        return NumaPlacement::FirstTouch;
+    }
+
+    std::string name(value);
+    if (name == "serial") {
+        return NumaPlacement::Serial;
+    }
+    if (name == "interleave") {
+        return NumaPlacement::Interleave;
+    }
+    if (name != "first-touch") {
+        std::cerr << "MATRIX_NUMA=" << name << " is not a placement, using first-touch\n";
+    }
+    return NumaPlacement::FirstTouch;
+}
+
+std::atomic<NumaPlacement>& active_placement() {
+    static std::atomic<NumaPlacement> placement{placement_from_env()};
+    return placement;
+}
+
+}
+
+void numa_set_placement(NumaPlacement placement) {
+    active_placement().store(placement, std::memory_order_relaxed);
+}
+
+NumaPlacement numa_placement() {
+    return active_placement().load(std::memory_order_relaxed);
+}
+
+const char* numa_placement_name(NumaPlacement placement) {
+    switch (placement) {
+    case NumaPlacement::Serial:
+        return "serial";
+    case NumaPlacement::Interleave:
+        return "interleave";
+    default:
+        return "first-touch";
+    }
+}
+
+size_t numa_node_count() {
+    size_t count = 0;
+    for (unsigned long word : node_mask()) {
+        count += __builtin_popcountl(word);
+    }
+    return count;
+}
+
+int numa_node_of(const void* addr) {
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, const_cast<void*>(addr), MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+        return -1;
+    }
+    return node;
+}
+
+std::vector<size_t> numa_page_histogram(const void* data, size_t bytes, size_t stride) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    std::vector<size_t> pages;
+    const char* begin = static_cast<const char*>(data);
+    for (size_t offset = 0; offset < bytes; offset += page * stride) {
+        int node = numa_node_of(begin + offset);
+        if (node < 0) {
+            continue;
+        }
+        if (pages.size() <= static_cast<size_t>(node)) {
+            pages.resize(node + 1, 0);
+        }
+        ++pages[node];
+    }
+    return pages;
+}
+
+void* numa_allocate(size_t bytes) {
+    if (bytes < NUMA_MIN_BYTES) {
+        return ::operator new(bytes, std::align_val_t(HEAP_ALIGNMENT));
+    }
+
+    // Huge-page sized blocks are over-mapped by one huge page and trimmed at both ends so
+    // they start on a huge-page boundary; what is left is exactly [data, data + length),
+    // as numa_deallocate expects.
+    size_t length = mapping_length(bytes);
+    size_t reserved = length >= HUGE_PAGE_SIZE ? length + HUGE_PAGE_SIZE : length;
+    void* raw = mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    char* begin = static_cast<char*>(raw);
+    char* data = begin;
+    if (reserved != length) {
+        data = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(begin) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+        // A failed trim gives the reservation back rather than exiting from an allocator.
+        if (data != begin && munmap(begin, data - begin) != 0) {
+            munmap(begin, reserved);
+            throw std::bad_alloc();
+        }
+        if (data + length != begin + reserved && munmap(data + length, begin + reserved - (data + length)) != 0) {
+            munmap(data, begin + reserved - data);
+            throw std::bad_alloc();
+        }
+        // A hint: without transparent huge pages the block simply keeps base pages.
+        madvise(data, length, MADV_HUGEPAGE);
+    }
+
+    if (numa_placement() == NumaPlacement::Interleave && numa_node_count() > 1) {
+        // Best effort: a kernel or container without NUMA support just keeps the default policy.
+        const std::vector<unsigned long>& mask = node_mask();
+        syscall(SYS_mbind, data, length, MPOL_INTERLEAVE, mask.data(), mask.size() * 8 * sizeof(unsigned long) + 1, 0);
+    }
+    return data;
+}
+
+void numa_deallocate(void* data, size_t bytes) {
+    if (bytes < NUMA_MIN_BYTES) {
+        ::operator delete(data, std::align_val_t(HEAP_ALIGNMENT));
+        return;
+    }
+    // Called from destructors, where a failure can be neither reported nor retried.
+    munmap(data, mapping_length(bytes));
+}
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/OutOfCore.h"
+#include "../include/Gemm.h"
+#include "../include/Matrix.h"
+#include "../include/MatrixAllocator.h"
+#include "../include/MatrixFile.h"
+#include "../include/check.hpp"
+
+namespace {
+
+class FileDescriptor {
+    int _fd;
+
+public:
+    FileDescriptor(const std::string& filename, int flags) : _fd(open(filename.c_str(), flags, 0644)) {
+        if (_fd == -1) {
+            throw std::runtime_error("Failed to open matrix file " + filename);
+        }
+    }
+    ~FileDescriptor() { close(_fd); }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int get() const { return _fd; }
+};
+
+bool same_file(int fd, int other) {
+    struct stat fd_stat, other_stat;
+    if (fstat(fd, &fd_stat) == -1 || fstat(other, &other_stat) == -1) {
+        throw std::runtime_error("Failed to stat matrix file");
+    }
+    return fd_stat.st_dev == other_stat.st_dev && fd_stat.st_ino == other_stat.st_ino;
+}
+
+// One background thread running I/O jobs in submission order. submit() returns a ticket;
+// wait(ticket) returns once that job and every earlier one has finished, and rethrows the
+// first error any job raised (jobs after a failure are skipped).
+class IoThread {
+    pthread_t _thread;
+    pthread_mutex_t _mutex;
+    pthread_cond_t _changed;
+    std::deque<std::function<void()>> _jobs;
+    uint64_t _submitted = 0;
+    uint64_t _completed = 0;
+    bool _stop = false;
+    std::exception_ptr _error;
+
+    static void* main(void* arg) {
+        IoThread& io = *static_cast<IoThread*>(arg);
+        check_result(pthread_mutex_lock(&io._mutex));
+        while (true) {
+            while (!io._stop && io._jobs.empty())
+                check_result(pthread_cond_wait(&io._changed, &io._mutex));
+            if (io._jobs.empty()) {
+                break;
+            }
+            std::function<void()> job = std::move(io._jobs.front());
+            io._jobs.pop_front();
+            bool failed = static_cast<bool>(io._error);
+            check_result(pthread_mutex_unlock(&io._mutex));
+
+            std::exception_ptr error;
+            if (!failed) {
+                try {
+                    job();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+
+            check_result(pthread_mutex_lock(&io._mutex));
+            if (error && !io._error) {
+                io._error = error;
+            }
+            ++io._completed;
+            check_result(pthread_cond_broadcast(&io._changed));
+        }
+        check_result(pthread_mutex_unlock(&io._mutex));
+        return nullptr;
+    }
+
+public:
+    IoThread() {
+        check_result(pthread_mutex_init(&_mutex, nullptr));
+        check_result(pthread_cond_init(&_changed, nullptr));
+        check_result(pthread_create(&_thread, nullptr, main, this));
+    }
+
+    // Finishes the queued jobs first: buffers they use are owned by the caller's frame.
+    ~IoThread() {
+        check_result(pthread_mutex_lock(&_mutex));
+        _stop = true;
+        check_result(pthread_cond_broadcast(&_changed));
+        check_result(pthread_mutex_unlock(&_mutex));
+        check_result(pthread_join(_thread, nullptr));
+        check_result(pthread_cond_destroy(&_changed));
+        check_result(pthread_mutex_destroy(&_mutex));
+    }
+
+    IoThread(const IoThread&) = delete;
+    IoThread& operator=(const IoThread&) = delete;
+
+    uint64_t submit(std::function<void()> job) {
+        check_result(pthread_mutex_lock(&_mutex));
+        _jobs.push_back(std::move(job));
+        uint64_t ticket = ++_submitted;
+        check_result(pthread_cond_broadcast(&_changed));
+        check_result(pthread_mutex_unlock(&_mutex));
+        return ticket;
+    }
+
+    void wait(uint64_t ticket) {
+        check_result(pthread_mutex_lock(&_mutex));
+        while (_completed < ticket)
+            check_result(pthread_cond_wait(&_changed, &_mutex));
+        std::exception_ptr error = _error;
+        check_result(pthread_mutex_unlock(&_mutex));
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+struct PanelPlan {
+    size_t rows;
+    size_t cols;
+};
+
+// Column panels of B get a quarter of the budget, rounded to whole 16-column strips when
+// that is not all of B; the A row panels and C blocks share the rest. Every panel is double
+// buffered so the next one can be read while the current one is in use.
+PanelPlan plan_panels(size_t m, size_t n, size_t k, size_t element, size_t acc_element, size_t budget) {
+    size_t b_column = 2 * k * element;
+    size_t cols = std::min(n, budget / 4 / b_column);
+    if (cols < n && cols >= 16) {
+        cols = cols / 16 * 16;
+    }
+    if (cols == 0) {
+        throw std::invalid_argument("Memory budget too small for one column panel of B");
+    }
+
+    size_t a_row = 2 * k * element + 2 * cols * acc_element;
+    size_t rows = std::min(m, (budget - cols * b_column) / a_row);
+    if (rows == 0) {
+        throw std::invalid_argument("Memory budget too small for one row panel of A");
+    }
+    return {rows, cols};
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+template <typename T>
+OutOfCoreStats multiply_out_of_core(const std::string& a_file, const std::string& b_file,
+                                    const std::string& c_file, const OutOfCoreOptions& options) {
+    using Acc = gemm_acc_t<T>;
+
+    FileDescriptor a_fd(a_file, O_RDONLY);
+    FileDescriptor b_fd(b_file, O_RDONLY);
+    MatrixFileInfo a_info = read_matrix_header(a_fd.get());
+    MatrixFileInfo b_info = read_matrix_header(b_fd.get());
+    if (a_info.cols != b_info.rows) {
+        throw std::invalid_argument("Matrix dimensions must agree for multiplication");
+    }
+    size_t m = a_info.rows;
+    size_t n = b_info.cols;
+    size_t k = a_info.cols;
+
+    // C is only truncated once it is known not to be one of the inputs under another name.
+    FileDescriptor c_fd(c_file, O_RDWR | O_CREAT);
+    if (same_file(c_fd.get(), a_fd.get()) || same_file(c_fd.get(), b_fd.get())) {
+        throw std::invalid_argument("Output matrix file must not be one of the input files");
+    }
+    if (ftruncate(c_fd.get(), 0) == -1) {
+        throw std::runtime_error("Failed to truncate matrix file " + c_file);
+    }
+    MatrixFileInfo c_info = create_matrix_file(c_fd.get(), m, n, dtype_of<Acc>());
+
+    OutOfCoreStats stats{};
+    if (m == 0 || n == 0 || k == 0) {
+        // create_matrix_file already left the payload reading as zeros.
+        return stats;
+    }
+
+    PanelPlan plan = plan_panels(m, n, k, sizeof(T), sizeof(Acc), options.memory_budget);
+    stats.panel_rows = plan.rows;
+    stats.panel_cols = plan.cols;
+    size_t row_panels = (m + plan.rows - 1) / plan.rows;
+    size_t col_panels = (n + plan.cols - 1) / plan.cols;
+    size_t steps = row_panels * col_panels;
+
+    // A streams through exactly once: SEQUENTIAL lets the kernel read further ahead, and each
+    // panel is dropped from the page cache once read (DONTNEED; SEQUENTIAL alone drops
+    // nothing), so A does not push out pages that are still useful, like B's. Not when A is
+    // also B, which is read again for every row panel.
+    posix_fadvise(a_fd.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+    bool drop_a = !same_file(a_fd.get(), b_fd.get());
+
+    std::vector<T, MatrixAllocator<T>> a_panels[2];
+    std::vector<T, MatrixAllocator<T>> b_panels[2];
+    std::vector<Acc, MatrixAllocator<Acc>> c_blocks[2];
+    for (size_t i = 0; i < 2; ++i) {
+        a_panels[i].resize(plan.rows * k);
+        b_panels[i].resize(k * plan.cols);
+        c_blocks[i].resize(plan.rows * plan.cols);
+    }
+
+    uint64_t a_ready[2] = {0, 0};
+    uint64_t b_ready[2] = {0, 0};
+    uint64_t c_written[2] = {0, 0};
+    IoThread io;
+
+    auto rows_of = [&](size_t panel) { return std::min(plan.rows, m - panel * plan.rows); };
+    auto cols_of = [&](size_t panel) { return std::min(plan.cols, n - panel * plan.cols); };
+    auto read_a = [&](size_t panel) {
+        T* out = a_panels[panel % 2].data();
+        a_ready[panel % 2] = io.submit([&, panel, out] {
+            read_matrix_block(a_fd.get(), a_info, panel * plan.rows, 0, rows_of(panel), k, out, k);
+            if (drop_a) {
+                size_t row_bytes = k * dtype_size(a_info.dtype);
+                posix_fadvise(a_fd.get(), a_info.payload_offset + panel * plan.rows * row_bytes,
+                              rows_of(panel) * row_bytes, POSIX_FADV_DONTNEED);
+            }
+        });
+        stats.bytes_read += rows_of(panel) * k * dtype_size(a_info.dtype);
+    };
+    // With a single column panel, B is read once and stays put.
+    auto read_b = [&](size_t step) {
+        size_t panel = step % col_panels;
+        T* out = b_panels[step % 2].data();
+        b_ready[step % 2] = io.submit([&, panel, out] {
+            read_matrix_block(b_fd.get(), b_info, 0, panel * plan.cols, k, cols_of(panel), out, cols_of(panel));
+        });
+        stats.bytes_read += k * cols_of(panel) * dtype_size(b_info.dtype);
+    };
+
+    read_a(0);
+    read_b(0);
+    for (size_t step = 0; step < steps; ++step) {
+        size_t row_panel = step / col_panels;
+        size_t col_panel = step % col_panels;
+        size_t b_slot = col_panels == 1 ? 0 : step % 2;
+
+        // Queue the next step's panels before computing this one; they go into the other
+        // buffers, which the previous step has finished with.
+        if (step + 1 < steps) {
+            if ((step + 1) % col_panels == 0) {
+                read_a(row_panel + 1);
+            }
+            if (col_panels > 1) {
+                read_b(step + 1);
+            }
+        }
+
+        auto wait_start = std::chrono::steady_clock::now();
+        io.wait(std::max({a_ready[row_panel % 2], b_ready[b_slot], c_written[step % 2]}));
+        stats.io_wait_seconds += seconds_since(wait_start);
+
+        size_t rows = rows_of(row_panel);
+        size_t cols = cols_of(col_panel);
+        Acc* block = c_blocks[step % 2].data();
+        auto compute_start = std::chrono::steady_clock::now();
+        Matrix<T>::parallel_multiply(ConstMatrixView<T>(a_panels[row_panel % 2].data(), rows, k),
+                                     ConstMatrixView<T>(b_panels[b_slot].data(), k, cols),
+                                     MatrixView<Acc>(block, rows, cols), options.num_threads);
+        stats.compute_seconds += seconds_since(compute_start);
+
+        c_written[step % 2] = io.submit([&, row_panel, col_panel, rows, cols, block] {
+            write_matrix_block(c_fd.get(), c_info, row_panel * plan.rows, col_panel * plan.cols, rows, cols,
+                               static_cast<const Acc*>(block), cols);
+        });
+        stats.bytes_written += rows * cols * sizeof(Acc);
+    }
+
+    auto wait_start = std::chrono::steady_clock::now();
+    io.wait(std::max(c_written[0], c_written[1]));
+    stats.io_wait_seconds += seconds_since(wait_start);
+    return stats;
+}
+
+template OutOfCoreStats multiply_out_of_core<double>(const std::string&, const std::string&, const std::string&,
+                                                     const OutOfCoreOptions&);
+template OutOfCoreStats multiply_out_of_core<float>(const std::string&, const std::string&, const std::string&,
+                                                    const OutOfCoreOptions&);
+template OutOfCoreStats multiply_out_of_core<int8_t>(const std::string&, const std::string&, const std::string&,
+                                                     const OutOfCoreOptions&);
+template OutOfCoreStats multiply_out_of_core<int32_t>(const std::string&, const std::string&, const std::string&,
+                                                      const OutOfCoreOptions&);
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <type_traits>
+
+#include "../include/Random.h"
+
+namespace {
+
+constexpr uint64_t PHILOX_M0 = 0xD2511F53;
+constexpr uint64_t PHILOX_M1 = 0xCD9E8D57;
+constexpr uint64_t PHILOX_W0 = 0x9E3779B9;
+constexpr uint64_t PHILOX_W1 = 0xBB67AE85;
+constexpr size_t LANES = 16;
+
+// Generated blocks per conversion batch; each block covers two elements.
+constexpr size_t BATCH = 128;
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+uint64_t initial_seed() {
+    if (const char* value = std::getenv("MATRIX_SEED")) {
+        return std::strtoull(value, nullptr, 10);
+    }
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) | device();
+}
+
+struct SeedStream {
+    std::atomic<uint64_t> base{initial_seed()};
+    std::atomic<uint64_t> next{0};
+};
+
+SeedStream& seed_stream() {
+    static SeedStream stream;
+    return stream;
+}
+
+constexpr uint64_t LOW = 0xFFFFFFFF;
+
+// One Philox round over LANES counters. The 32-bit words live in 64-bit lanes so that
+// M * c maps onto pmuludq and the loop vectorizes.
+[[gnu::always_inline]] inline void philox_round(uint64_t* __restrict c0, uint64_t* __restrict c1, uint64_t* __restrict c2,
+                  uint64_t* __restrict c3, uint64_t k0, uint64_t k1) {
+    for (size_t l = 0; l < LANES; ++l) {
+        uint64_t p0 = PHILOX_M0 * c0[l];
+        uint64_t p1 = PHILOX_M1 * c2[l];
+        uint64_t n0 = (p1 >> 32) ^ c1[l] ^ k0;
+        uint64_t n2 = (p0 >> 32) ^ c3[l] ^ k1;
+        c1[l] = p1 & LOW;
+        c3[l] = p0 & LOW;
+        c0[l] = n0;
+        c2[l] = n2;
+    }
+}
+
+// Up to LANES blocks at a time, laid out lane-major.
+[[gnu::always_inline]] inline void philox_lanes(uint64_t key, uint64_t first, size_t count, uint64_t* out) {
+    uint64_t c0[LANES], c1[LANES], c2[LANES], c3[LANES];
+    for (size_t l = 0; l < LANES; ++l) {
+        uint64_t counter = first + l;
+        c0[l] = counter & LOW;
+        c1[l] = counter >> 32;
+        c2[l] = 0;
+        c3[l] = 0;
+    }
+
+    uint64_t k0 = key & LOW;
+    uint64_t k1 = key >> 32;
+    for (int round = 0; round < 10; ++round) {
+        philox_round(c0, c1, c2, c3, k0, k1);
+        k0 = (k0 + PHILOX_W0) & LOW;
+        k1 = (k1 + PHILOX_W1) & LOW;
+    }
+
+    for (size_t l = 0; l < count; ++l) {
+        out[2 * l] = c0[l] | c1[l] << 32;
+        out[2 * l + 1] = c2[l] | c3[l] << 32;
+    }
+}
+
+}
+
+// The same source built for several ISAs and picked at load time: the rounds are plain
+// integer lane loops, so unlike the GEMM kernels they need no hand-written intrinsics.
+#ifdef MATRIX_X86_KERNELS
+[[gnu::target_clones("avx512f", "avx2", "default")]]
+#endif
+void philox4x32(uint64_t key, uint64_t first, size_t count, uint64_t* out) {
+    for (size_t done = 0; done < count; done += LANES) {
+        philox_lanes(key, first + done, std::min(LANES, count - done), out + 2 * done);
+    }
+}
+
+template <typename T>
+void random_uniform(uint64_t seed, size_t first, size_t count, T min, T max, T* out) {
+    uint64_t bits[2 * BATCH];
+    size_t index = first;
+    size_t end = first + count;
+
+    while (index < end) {
+        // Element i is half i % 2 of block i / 2, wherever the range starts.
+        uint64_t block = index / 2;
+        size_t blocks = std::min<size_t>(BATCH, (end - 1) / 2 - block + 1);
+        philox4x32(seed, block, blocks, bits);
+
+        size_t available = std::min(2 * blocks - index % 2, end - index);
+        const uint64_t* source = bits + index % 2;
+        T* dst = out + (index - first);
+        if constexpr (std::is_integral_v<T>) {
+            // Top 32 bits scaled to the range; the bias is at most range / 2^32.
+            uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min) + 1;
+            for (size_t j = 0; j < available; ++j) {
+                dst[j] = static_cast<T>(min + static_cast<int64_t>(((source[j] >> 32) * range) >> 32));
+            }
+        } else {
+            // unit < 1, but min + unit * scale can still round up to max (always possible
+            // when it is narrowed to float), so clamp to keep the range half-open.
+            double scale = static_cast<double>(max) - min;
+            T below = std::nextafter(max, min);
+            for (size_t j = 0; j < available; ++j) {
+                double unit = static_cast<double>(source[j] >> 11) * 0x1.0p-53;
+                dst[j] = std::min(static_cast<T>(min + unit * scale), below);
+            }
+        }
+        index += available;
+    }
+}
+
+void random_set_seed(uint64_t seed) {
+    seed_stream().base.store(seed, std::memory_order_relaxed);
+    seed_stream().next.store(0, std::memory_order_relaxed);
+}
+
+uint64_t random_next_seed() {
+    SeedStream& stream = seed_stream();
+    uint64_t n = stream.next.fetch_add(1, std::memory_order_relaxed);
+    return splitmix64(stream.base.load(std::memory_order_relaxed) ^ splitmix64(n));
+}
+
+template void random_uniform<float>(uint64_t, size_t, size_t, float, float, float*);
+template void random_uniform<double>(uint64_t, size_t, size_t, double, double, double*);
+template void random_uniform<int8_t>(uint64_t, size_t, size_t, int8_t, int8_t, int8_t*);
+template void random_uniform<int32_t>(uint64_t, size_t, size_t, int32_t, int32_t, int32_t*);
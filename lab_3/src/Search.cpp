@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "../include/Search.h"
+#include "../include/Gemm.h"
+#include "../include/SearchKernels.h"
+#include "../include/ThreadPool.h"
+
+SearchPredicate SearchPredicate::equal(int32_t target) {
+    return {Kind::Equal, target, target, {}};
+}
+
+SearchPredicate SearchPredicate::range(int32_t low, int32_t high) {
+    if (low > high) {
+        throw std::invalid_argument("Search range must have low <= high");
+    }
+    return {Kind::Range, low, high, {}};
+}
+
+SearchPredicate SearchPredicate::any_of(std::vector<int32_t> targets) {
+    return {Kind::AnyOf, 0, 0, std::move(targets)};
+}
+
+bool SearchPredicate::matches(int32_t value) const {
+    switch (kind) {
+    case Kind::Equal:
+        return value == low;
+    case Kind::Range:
+        return low <= value && value <= high;
+    case Kind::AnyOf:
+        return std::find(targets.begin(), targets.end(), value) != targets.end();
+    }
+    return false;
+}
+
+namespace {
+
+// Portable kernels: the predicate is resolved once per chunk so the loops stay simple
+// enough for the compiler to vectorize the counting ones.
+template <typename Fn>
+auto with_matcher(const SearchKernelArgs& args, Fn fn) {
+    switch (args.kind) {
+    case SearchPredicate::Kind::Equal:
+        return fn([value = args.low](int32_t x) { return x == value; });
+    case SearchPredicate::Kind::Range:
+        return fn([low = args.low, high = args.high](int32_t x) { return low <= x && x <= high; });
+    case SearchPredicate::Kind::AnyOf:
+        break;
+    }
+    return fn([&args](int32_t x) {
+        return std::find(args.targets, args.targets + args.target_count, x) != args.targets + args.target_count;
+    });
+}
+
+size_t generic_count(const int32_t* data, size_t n, const SearchKernelArgs& args) {
+    return with_matcher(args, [&](auto match) {
+        size_t count = 0;
+        for (size_t i = 0; i < n; ++i) {
+            count += match(data[i]);
+        }
+        return count;
+    });
+}
+
+size_t generic_find(const int32_t* data, size_t n, const SearchKernelArgs& args, uint32_t* out) {
+    return with_matcher(args, [&](auto match) {
+        size_t found = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (match(data[i])) {
+                out[found++] = static_cast<uint32_t>(i);
+            }
+        }
+        return found;
+    });
+}
+
+const SearchKernels generic_kernels = {"generic", generic_count, generic_find};
+
+const SearchKernels& active_kernels() {
+#ifdef MATRIX_X86_KERNELS
+    switch (gemm_isa()) {
+    case GemmIsa::Avx512:
+        return search_kernels_avx512;
+    case GemmIsa::Avx2:
+        return search_kernels_avx2;
+    default:
+        break;
+    }
+#endif
+    return generic_kernels;
+}
+
+SearchKernelArgs kernel_args(const SearchPredicate& predicate) {
+    return {predicate.kind, predicate.low, predicate.high, predicate.targets.data(), predicate.targets.size()};
+}
+
+// Runs fn(chunk, first, length) for every SEARCH_CHUNK of [0, size) on the pool.
+template <typename Fn>
+void for_each_chunk(size_t size, size_t num_threads, Fn fn) {
+    size_t chunks = (size + SEARCH_CHUNK - 1) / SEARCH_CHUNK;
+    ThreadPool& pool = ThreadPool::global();
+    size_t workers = num_threads == 0 ? pool.size() : std::min(num_threads, pool.size());
+    pool.parallel_for(chunks, [&](size_t c) {
+        size_t first = c * SEARCH_CHUNK;
+        fn(c, first, std::min(SEARCH_CHUNK, size - first));
+    }, workers);
+}
+
+}
+
+size_t search_count(const int32_t* data, size_t size, const SearchPredicate& predicate, size_t num_threads) {
+    const SearchKernels& kernels = active_kernels();
+    SearchKernelArgs args = kernel_args(predicate);
+
+    std::vector<size_t> counts((size + SEARCH_CHUNK - 1) / SEARCH_CHUNK);
+    for_each_chunk(size, num_threads, [&](size_t c, size_t first, size_t length) {
+        counts[c] = kernels.count(data + first, length, args);
+    });
+    return std::accumulate(counts.begin(), counts.end(), size_t(0));
+}
+
+std::vector<size_t> search_find(const int32_t* data, size_t size, const SearchPredicate& predicate,
+                                size_t num_threads) {
+    const SearchKernels& kernels = active_kernels();
+    SearchKernelArgs args = kernel_args(predicate);
+
+    // Kernels write chunk-relative offsets into a per-thread scratch buffer sized for the
+    // worst case; each chunk then keeps an exact-size copy, so sparse results cost little.
+    std::vector<std::vector<uint32_t>> matches((size + SEARCH_CHUNK - 1) / SEARCH_CHUNK);
+    for_each_chunk(size, num_threads, [&](size_t c, size_t first, size_t length) {
+        thread_local std::vector<uint32_t> scratch(SEARCH_CHUNK);
+        size_t found = kernels.find(data + first, length, args, scratch.data());
+        matches[c].assign(scratch.begin(), scratch.begin() + found);
+    });
+
+    std::vector<size_t> offsets(matches.size() + 1, 0);
+    for (size_t c = 0; c < matches.size(); ++c) {
+        offsets[c + 1] = offsets[c] + matches[c].size();
+    }
+
+    std::vector<size_t> result(offsets.back());
+    for_each_chunk(size, num_threads, [&](size_t c, size_t first, size_t) {
+        size_t* out = result.data() + offsets[c];
+        for (uint32_t offset : matches[c]) {
+            *out++ = first + offset;
+        }
+    });
+    return result;
+}
+
+namespace {
+
+constexpr size_t PREFILTER = 16;
+// Interleaved counter sets, so runs of equal values do not serialize on one counter.
+constexpr size_t COUNTER_LANES = 4;
+
+// The distinct targets and a lookup from an element to its index among them. Slots are
+// numbered from 1; slot 0 stands for "not a target", so callers can count and store
+// unconditionally instead of branching on every element.
+class TargetTable {
+    std::vector<int32_t> _unique;
+    uint32_t _low;
+    uint32_t _span;                 // max - min, as unsigned
+    std::vector<uint16_t> _direct;  // value - min -> slot, then one 0 for everything outside
+    std::vector<int32_t> _keys;     // open addressing, used when the span is too wide
+    std::vector<uint32_t> _slots;   // 0 marks an empty entry
+    uint32_t _shift;
+
+    uint32_t hash(int32_t value) const {
+        return (static_cast<uint32_t>(value) * 0x9E3779B1u) >> _shift;
+    }
+
+public:
+    explicit TargetTable(const std::vector<int32_t>& targets) : _unique(targets), _low(0), _span(0), _shift(32) {
+        std::sort(_unique.begin(), _unique.end());
+        _unique.erase(std::unique(_unique.begin(), _unique.end()), _unique.end());
+        if (_unique.empty()) {
+            return;
+        }
+        _low = static_cast<uint32_t>(_unique.front());
+        _span = static_cast<uint32_t>(_unique.back()) - _low;
+
+        if (_span < SEARCH_TABLE_SPAN && _unique.size() < UINT16_MAX) {
+            _direct.assign(size_t(_span) + 2, 0);
+            for (size_t s = 0; s < _unique.size(); ++s) {
+                _direct[static_cast<uint32_t>(_unique[s]) - _low] = static_cast<uint16_t>(s + 1);
+            }
+            return;
+        }
+
+        // Kept at most 1/8 full, so an element that is not a target nearly always lands on an
+        // empty entry and the probe loop is predictable.
+        size_t capacity = 64;
+        _shift = 26;
+        while (capacity < 8 * _unique.size()) {
+            capacity *= 2;
+            --_shift;
+        }
+        _keys.assign(capacity, 0);
+        _slots.assign(capacity, 0);
+        for (size_t s = 0; s < _unique.size(); ++s) {
+            uint32_t h = hash(_unique[s]);
+            while (_slots[h] != 0) {
+                h = (h + 1) & (capacity - 1);
+            }
+            _keys[h] = _unique[s];
+            _slots[h] = static_cast<uint32_t>(s + 1);
+        }
+    }
+
+    // Distinct targets; slots run from 1 to size().
+    size_t size() const { return _unique.size(); }
+
+    size_t slot_of(int32_t target) const {
+        return std::lower_bound(_unique.begin(), _unique.end(), target) - _unique.begin() + 1;
+    }
+
+    uint32_t lookup(int32_t value) const {
+        if (!_direct.empty()) {
+            return _direct[std::min(static_cast<uint32_t>(value) - _low, _span + 1)];
+        }
+        uint32_t h = hash(value);
+        while (_slots[h] != 0 && _keys[h] != value) {
+            h = (h + 1) & (_slots.size() - 1);
+        }
+        return _slots[h];
+    }
+
+    // Calls fn(lookup(data[i]), i) for the elements of data[0, n), except for runs of
+    // PREFILTER that lie wholly outside [min target, max target] and so hold no target.
+    template <typename Fn>
+    void scan(const int32_t* data, size_t n, Fn fn) const {
+        if (_unique.empty()) {
+            return;
+        }
+        size_t i = 0;
+        for (; i + PREFILTER <= n; i += PREFILTER) {
+            bool any = false;
+            for (size_t j = 0; j < PREFILTER; ++j) {
+                any |= static_cast<uint32_t>(data[i + j]) - _low <= _span;
+            }
+            if (any) {
+                for (size_t j = i; j < i + PREFILTER; ++j) {
+                    fn(lookup(data[j]), j);
+                }
+            }
+        }
+        for (; i < n; ++i) {
+            fn(lookup(data[i]), i);
+        }
+    }
+};
+
+// Matches per slot in data[0, n) into counts[0, table.size() + 1), slot 0 included.
+void count_slots(const TargetTable& table, const int32_t* data, size_t n, uint32_t* counts) {
+    size_t stride = table.size() + 1;
+    thread_local std::vector<uint32_t> lanes;
+    lanes.assign(COUNTER_LANES * stride, 0);
+    uint32_t* lane = lanes.data();
+    table.scan(data, n, [lane, stride](uint32_t s, size_t i) { ++lane[(i % COUNTER_LANES) * stride + s]; });
+    for (size_t s = 0; s < stride; ++s) {
+        uint32_t total = 0;
+        for (size_t l = 0; l < COUNTER_LANES; ++l) {
+            total += lane[l * stride + s];
+        }
+        counts[s] = total;
+    }
+}
+
+}
+
+std::vector<size_t> search_count_many(const int32_t* data, size_t size, const std::vector<int32_t>& targets,
+                                      size_t num_threads) {
+    TargetTable table(targets);
+    size_t stride = table.size() + 1;
+    size_t chunks = (size + SEARCH_CHUNK - 1) / SEARCH_CHUNK;
+
+    // Chunk-local counters, summed per target at the end.
+    std::vector<uint32_t> counts(chunks * stride, 0);
+    for_each_chunk(size, num_threads, [&](size_t c, size_t first, size_t length) {
+        count_slots(table, data + first, length, counts.data() + c * stride);
+    });
+
+    std::vector<size_t> totals(stride, 0);
+    for (size_t c = 0; c < chunks; ++c) {
+        for (size_t s = 1; s < stride; ++s) {
+            totals[s] += counts[c * stride + s];
+        }
+    }
+
+    std::vector<size_t> result(targets.size());
+    for (size_t t = 0; t < targets.size(); ++t) {
+        result[t] = totals[table.slot_of(targets[t])];
+    }
+    return result;
+}
+
+std::vector<std::vector<size_t>> search_find_many(const int32_t* data, size_t size,
+                                                  const std::vector<int32_t>& targets, size_t num_threads) {
+    TargetTable table(targets);
+    size_t stride = table.size() + 1;
+    size_t chunks = (size + SEARCH_CHUNK - 1) / SEARCH_CHUNK;
+
+    // Every chunk counts its matches per target, then scans again (the chunk is still in
+    // cache) to lay out its offsets grouped by target. Elements that match nothing are
+    // written to one spare entry past the end rather than branched around.
+    std::vector<uint32_t> counts(chunks * stride, 0);
+    std::vector<std::vector<uint32_t>> matches(chunks);
+    for_each_chunk(size, num_threads, [&](size_t c, size_t first, size_t length) {
+        uint32_t* local = counts.data() + c * stride;
+        count_slots(table, data + first, length, local);
+
+        std::vector<uint32_t> next(stride, 0);
+        for (size_t s = 2; s < stride; ++s) {
+            next[s] = next[s - 1] + local[s - 1];
+        }
+        uint32_t total = stride > 1 ? next[stride - 1] + local[stride - 1] : 0;
+        next[0] = total;
+        matches[c].resize(total + 1);
+        uint32_t* out = matches[c].data();
+        uint32_t* cursor = next.data();
+        table.scan(data + first, length, [out, cursor](uint32_t s, size_t i) {
+            out[cursor[s]] = static_cast<uint32_t>(i);
+            cursor[s] += s != 0;
+        });
+        matches[c].resize(total);
+    });
+
+    // positions[c * stride + s]: where chunk c's matches of slot s start in its result.
+    std::vector<size_t> positions(chunks * stride, 0);
+    std::vector<std::vector<size_t>> slot_results(stride);
+    for (size_t s = 1; s < stride; ++s) {
+        size_t total = 0;
+        for (size_t c = 0; c < chunks; ++c) {
+            positions[c * stride + s] = total;
+            total += counts[c * stride + s];
+        }
+        slot_results[s].resize(total);
+    }
+
+    for_each_chunk(size, num_threads, [&](size_t c, size_t first, size_t) {
+        const uint32_t* in = matches[c].data();
+        for (size_t s = 1; s < stride; ++s) {
+            size_t* out = slot_results[s].data() + positions[c * stride + s];
+            for (uint32_t k = 0; k < counts[c * stride + s]; ++k) {
+                *out++ = first + *in++;
+            }
+        }
+    });
+
+    // Duplicate targets copy the result; the last one takes it.
+    std::vector<size_t> remaining(stride, 0);
+    for (int32_t target : targets) {
+        ++remaining[table.slot_of(target)];
+    }
+    std::vector<std::vector<size_t>> result(targets.size());
+    for (size_t t = 0; t < targets.size(); ++t) {
+        size_t s = table.slot_of(targets[t]);
+        if (--remaining[s] == 0) {
+            result[t] = std::move(slot_results[s]);
+        } else {
+            result[t] = slot_results[s];
+        }
+    }
+    return result;
+}
@@ -0,0 +1,130 @@
+#include <immintrin.h>
+
+#include "../include/SearchKernels.h"
+
+namespace {
+
+// Each matcher turns 8 elements into a lane mask (all ones where the element matches) and
+// also answers for single elements, which the tails use.
+struct EqualMatch {
+    __m256i target;
+    int32_t value;
+
+    explicit EqualMatch(const SearchKernelArgs& args) : target(_mm256_set1_epi32(args.low)), value(args.low) {}
+    __m256i operator()(__m256i x) const { return _mm256_cmpeq_epi32(x, target); }
+    bool operator()(int32_t x) const { return x == value; }
+};
+
+// low <= x <= high as one unsigned compare, x - low <= high - low. AVX2 only compares
+// signed, so both sides get their sign bit flipped first.
+struct RangeMatch {
+    __m256i low;
+    __m256i span;
+    int32_t low_value;
+    uint32_t span_value;
+
+    explicit RangeMatch(const SearchKernelArgs& args)
+        : low(_mm256_set1_epi32(args.low)),
+          span(_mm256_set1_epi32(static_cast<int32_t>((static_cast<uint32_t>(args.high) - static_cast<uint32_t>(args.low)) ^ 0x80000000u))),
+          low_value(args.low),
+          span_value(static_cast<uint32_t>(args.high) - static_cast<uint32_t>(args.low)) {}
+
+    __m256i operator()(__m256i x) const {
+        __m256i offset = _mm256_xor_si256(_mm256_sub_epi32(x, low), _mm256_set1_epi32(INT32_MIN));
+        return _mm256_xor_si256(_mm256_cmpgt_epi32(offset, span), _mm256_set1_epi32(-1));
+    }
+    bool operator()(int32_t x) const { return static_cast<uint32_t>(x) - static_cast<uint32_t>(low_value) <= span_value; }
+};
+
+struct AnyOfMatch {
+    const int32_t* targets;
+    size_t count;
+
+    explicit AnyOfMatch(const SearchKernelArgs& args) : targets(args.targets), count(args.target_count) {}
+    __m256i operator()(__m256i x) const {
+        __m256i mask = _mm256_setzero_si256();
+        for (size_t t = 0; t < count; ++t) {
+            mask = _mm256_or_si256(mask, _mm256_cmpeq_epi32(x, _mm256_set1_epi32(targets[t])));
+        }
+        return mask;
+    }
+    bool operator()(int32_t x) const {
+        for (size_t t = 0; t < count; ++t) {
+            if (x == targets[t]) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Matching lanes are -1, so subtracting the mask counts per lane; two accumulators keep two
+// loads in flight. A chunk is far too short for a lane to overflow.
+template <typename Match>
+size_t count_with(const int32_t* data, size_t n, const Match& match) {
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_sub_epi32(acc0, match(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i))));
+        acc1 = _mm256_sub_epi32(acc1, match(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 8))));
+    }
+    __m256i acc = _mm256_add_epi32(acc0, acc1);
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    size_t count = static_cast<uint32_t>(_mm_cvtsi128_si32(sum));
+
+    for (; i < n; ++i) {
+        count += match(data[i]);
+    }
+    return count;
+}
+
+template <typename Match>
+size_t find_with(const int32_t* data, size_t n, const Match& match, uint32_t* out) {
+    size_t found = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i hits = match(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(hits)));
+        while (mask != 0) {
+            out[found++] = static_cast<uint32_t>(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    for (; i < n; ++i) {
+        if (match(data[i])) {
+            out[found++] = static_cast<uint32_t>(i);
+        }
+    }
+    return found;
+}
+
+size_t count(const int32_t* data, size_t n, const SearchKernelArgs& args) {
+    switch (args.kind) {
+    case SearchPredicate::Kind::Equal:
+        return count_with(data, n, EqualMatch(args));
+    case SearchPredicate::Kind::Range:
+        return count_with(data, n, RangeMatch(args));
+    case SearchPredicate::Kind::AnyOf:
+        return count_with(data, n, AnyOfMatch(args));
+    }
+    return 0;
+}
+
+size_t find(const int32_t* data, size_t n, const SearchKernelArgs& args, uint32_t* out) {
+    switch (args.kind) {
+    case SearchPredicate::Kind::Equal:
+        return find_with(data, n, EqualMatch(args), out);
+    case SearchPredicate::Kind::Range:
+        return find_with(data, n, RangeMatch(args), out);
+    case SearchPredicate::Kind::AnyOf:
+        return find_with(data, n, AnyOfMatch(args), out);
+    }
+    return 0;
+}
+
+}
+
+const SearchKernels search_kernels_avx2 = {"avx2", count, find};
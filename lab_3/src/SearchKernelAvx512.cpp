@@ -0,0 +1,130 @@
+#include <immintrin.h>
+
+#include "../include/SearchKernels.h"
+
+namespace {
+
+// AVX-512 compares straight into 16-bit lane masks, and unsigned compares make the range
+// test a single instruction after the subtraction.
+struct EqualMatch {
+    __m512i target;
+    int32_t value;
+
+    explicit EqualMatch(const SearchKernelArgs& args) : target(_mm512_set1_epi32(args.low)), value(args.low) {}
+    __mmask16 operator()(__m512i x) const { return _mm512_cmpeq_epi32_mask(x, target); }
+    bool operator()(int32_t x) const { return x == value; }
+};
+
+struct RangeMatch {
+    __m512i low;
+    __m512i span;
+    int32_t low_value;
+    uint32_t span_value;
+
+    explicit RangeMatch(const SearchKernelArgs& args)
+        : low(_mm512_set1_epi32(args.low)),
+          span(_mm512_set1_epi32(static_cast<int32_t>(static_cast<uint32_t>(args.high) - static_cast<uint32_t>(args.low)))),
+          low_value(args.low),
+          span_value(static_cast<uint32_t>(args.high) - static_cast<uint32_t>(args.low)) {}
+
+    __mmask16 operator()(__m512i x) const { return _mm512_cmple_epu32_mask(_mm512_sub_epi32(x, low), span); }
+    bool operator()(int32_t x) const { return static_cast<uint32_t>(x) - static_cast<uint32_t>(low_value) <= span_value; }
+};
+
+struct AnyOfMatch {
+    const int32_t* targets;
+    size_t count;
+
+    explicit AnyOfMatch(const SearchKernelArgs& args) : targets(args.targets), count(args.target_count) {}
+    __mmask16 operator()(__m512i x) const {
+        __mmask16 mask = 0;
+        for (size_t t = 0; t < count; ++t) {
+            mask |= _mm512_cmpeq_epi32_mask(x, _mm512_set1_epi32(targets[t]));
+        }
+        return mask;
+    }
+    bool operator()(int32_t x) const {
+        for (size_t t = 0; t < count; ++t) {
+            if (x == targets[t]) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Masked increments count per lane without popcnt; two accumulators keep two loads in flight.
+template <typename Match>
+size_t count_with(const int32_t* data, size_t n, const Match& match) {
+    const __m512i one = _mm512_set1_epi32(1);
+    __m512i acc0 = _mm512_setzero_si512();
+    __m512i acc1 = _mm512_setzero_si512();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm512_mask_add_epi32(acc0, match(_mm512_loadu_si512(data + i)), acc0, one);
+        acc1 = _mm512_mask_add_epi32(acc1, match(_mm512_loadu_si512(data + i + 16)), acc1, one);
+    }
+    if (i + 16 <= n) {
+        acc0 = _mm512_mask_add_epi32(acc0, match(_mm512_loadu_si512(data + i)), acc0, one);
+        i += 16;
+    }
+    // Summed through memory: GCC 12's _mm512_reduce_add_epi32 trips -Wmaybe-uninitialized.
+    alignas(64) uint32_t lanes[16];
+    _mm512_store_si512(lanes, _mm512_add_epi32(acc0, acc1));
+    size_t count = 0;
+    for (uint32_t lane : lanes) {
+        count += lane;
+    }
+
+    // The tail is one masked load: lanes past n are neither read nor counted.
+    if (i < n) {
+        __mmask16 valid = static_cast<__mmask16>((1u << (n - i)) - 1);
+        __mmask16 hits = match(_mm512_maskz_loadu_epi32(valid, data + i)) & valid;
+        count += __builtin_popcount(hits);
+    }
+    return count;
+}
+
+// Offsets of the matching lanes are packed to out with one compress-store per 16 elements.
+template <typename Match>
+size_t find_with(const int32_t* data, size_t n, const Match& match, uint32_t* out) {
+    const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    size_t found = 0;
+    size_t i = 0;
+    for (; i < n; i += 16) {
+        __mmask16 valid = n - i >= 16 ? __mmask16(0xFFFF) : static_cast<__mmask16>((1u << (n - i)) - 1);
+        __mmask16 hits = match(_mm512_maskz_loadu_epi32(valid, data + i)) & valid;
+        __m512i offsets = _mm512_add_epi32(lanes, _mm512_set1_epi32(static_cast<int32_t>(i)));
+        _mm512_mask_compressstoreu_epi32(out + found, hits, offsets);
+        found += __builtin_popcount(hits);
+    }
+    return found;
+}
+
+size_t count(const int32_t* data, size_t n, const SearchKernelArgs& args) {
+    switch (args.kind) {
+    case SearchPredicate::Kind::Equal:
+        return count_with(data, n, EqualMatch(args));
+    case SearchPredicate::Kind::Range:
+        return count_with(data, n, RangeMatch(args));
+    case SearchPredicate::Kind::AnyOf:
+        return count_with(data, n, AnyOfMatch(args));
+    }
+    return 0;
+}
+
+size_t find(const int32_t* data, size_t n, const SearchKernelArgs& args, uint32_t* out) {
+    switch (args.kind) {
+    case SearchPredicate::Kind::Equal:
+        return find_with(data, n, EqualMatch(args), out);
+    case SearchPredicate::Kind::Range:
+        return find_with(data, n, RangeMatch(args), out);
+    case SearchPredicate::Kind::AnyOf:
+        return find_with(data, n, AnyOfMatch(args), out);
+    }
+    return 0;
+}
+
+}
+
+const SearchKernels search_kernels_avx512 = {"avx512", count, find};
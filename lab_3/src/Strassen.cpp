@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "../include/Gemm.h"
+#include "../include/ThreadPool.h"
+
+namespace {
+
+constexpr size_t DEFAULT_CROSSOVER = 1024;
+
+size_t default_crossover() {
+    static const size_t crossover = [] {
+        if (const char* value = std::getenv("MATRIX_STRASSEN_CROSSOVER")) {
+            long requested = std::strtol(value, nullptr, 10);
+            if (requested > 0) {
+                return static_cast<size_t>(requested);
+            }
+        }
+        return DEFAULT_CROSSOVER;
+    }();
+    return crossover;
+}
+
+// Bump allocator over a caller-owned buffer. Passed by value, so whatever a recursive
+// call takes is given back when it returns.
+template <typename T>
+struct Arena {
+    T* next;
+
+    T* take(size_t count) {
+        T* block = next;
+        next += count;
+        return block;
+    }
+};
+
+// out = op(x, y) element-wise over rows x cols blocks; out may alias x or y.
+template <typename T, typename Op>
+void combine(size_t rows, size_t cols, const T* x, size_t ldx, const T* y, size_t ldy, T* out, size_t ldo, Op op) {
+    for (size_t i = 0; i < rows; ++i) {
+        const T* xr = x + i * ldx;
+        const T* yr = y + i * ldy;
+        T* outr = out + i * ldo;
+        for (size_t j = 0; j < cols; ++j) {
+            outr[j] = op(xr[j], yr[j]);
+        }
+    }
+}
+
+bool recurse(size_t m, size_t n, size_t k, size_t crossover) {
+    return std::min({m, n, k}) >= crossover;
+}
+
+// Scratch used by strassen_serial for an m x n x k product.
+size_t serial_scratch(size_t m, size_t n, size_t k, size_t crossover) {
+    if (!recurse(m, n, k, crossover)) {
+        return 0;
+    }
+    size_t mh = m / 2, nh = n / 2, kh = k / 2;
+    return mh * std::max(kh, nh) + kh * nh + serial_scratch(mh, nh, kh, crossover);
+}
+
+// Scratch used by strassen_parallel: all eight operand sums, the three products that do
+// not land in C, and a serial arena per product.
+size_t parallel_scratch(size_t m, size_t n, size_t k, size_t crossover) {
+    size_t mh = m / 2, nh = n / 2, kh = k / 2;
+    return 4 * mh * kh + 4 * kh * nh + 3 * mh * nh + 7 * serial_scratch(mh, nh, kh, crossover);
+}
+
+// The even-sized 2mh x 2nh x 2kh part is done by the caller; this adds the odd row, column
+// and inner index, if any.
+template <typename T>
+void peel(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc) {
+    size_t m2 = m / 2 * 2, n2 = n / 2 * 2, k2 = k / 2 * 2;
+    if (k2 != k) {
+        for (size_t i = 0; i < m2; ++i) {
+            T aik = a[i * lda + k2];
+            for (size_t j = 0; j < n2; ++j) {
+                c[i * ldc + j] += aik * b[k2 * ldb + j];
+            }
+        }
+    }
+    if (n2 != n) {
+        gemm_blocked(m2, n - n2, k, a, lda, b + n2, ldb, c + n2, ldc);
+    }
+    if (m2 != m) {
+        gemm_blocked(m - m2, n, k, a + m2 * lda, lda, b, ldb, c + m2 * ldc, ldc);
+    }
+}
+
+// Winograd's schedule with two temporaries, X (S_i and then P1) and Y (T_i); the other
+// products are formed in the quadrants of C and combined in place.
+template <typename T>
+void strassen_serial(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb,
+                     T* c, size_t ldc, size_t crossover, Arena<T> arena) {
+    if (!recurse(m, n, k, crossover)) {
+        gemm_blocked(m, n, k, a, lda, b, ldb, c, ldc);
+        return;
+    }
+
+    size_t mh = m / 2, nh = n / 2, kh = k / 2;
+    const T *a11 = a, *a12 = a + kh, *a21 = a + mh * lda, *a22 = a21 + kh;
+    const T *b11 = b, *b12 = b + nh, *b21 = b + kh * ldb, *b22 = b21 + nh;
+    T *c11 = c, *c12 = c + nh, *c21 = c + mh * ldc, *c22 = c21 + nh;
+
+    size_t ldx = std::max(kh, nh);
+    T* x = arena.take(mh * ldx);
+    T* y = arena.take(kh * nh);
+    auto product = [&](const T* p, size_t ldp, const T* q, size_t ldq, T* r, size_t ldr) {
+        strassen_serial(mh, nh, kh, p, ldp, q, ldq, r, ldr, crossover, arena);
+    };
+
+    combine(mh, kh, a11, lda, a21, lda, x, ldx, std::minus<T>());   // S3
+    combine(kh, nh, b22, ldb, b12, ldb, y, nh, std::minus<T>());    // T3
+    product(x, ldx, y, nh, c21, ldc);                               // P7
+    combine(mh, kh, a21, lda, a22, lda, x, ldx, std::plus<T>());    // S1
+    combine(kh, nh, b12, ldb, b11, ldb, y, nh, std::minus<T>());    // T1
+    product(x, ldx, y, nh, c22, ldc);                               // P5
+    combine(mh, kh, x, ldx, a11, lda, x, ldx, std::minus<T>());     // S2 = S1 - A11
+    combine(kh, nh, b22, ldb, y, nh, y, nh, std::minus<T>());       // T2 = B22 - T1
+    product(x, ldx, y, nh, c12, ldc);                               // P6
+    combine(mh, kh, a12, lda, x, ldx, x, ldx, std::minus<T>());     // S4 = A12 - S2
+    combine(kh, nh, y, nh, b21, ldb, y, nh, std::minus<T>());       // T4 = T2 - B21
+    product(x, ldx, b22, ldb, c11, ldc);                            // P3
+    product(a11, lda, b11, ldb, x, ldx);                            // P1
+
+    combine(mh, nh, x, ldx, c12, ldc, c12, ldc, std::plus<T>());    // U2 = P1 + P6
+    combine(mh, nh, c12, ldc, c21, ldc, c21, ldc, std::plus<T>());  // U3 = U2 + P7
+    combine(mh, nh, c12, ldc, c22, ldc, c12, ldc, std::plus<T>());  // U4 = U2 + P5
+    combine(mh, nh, c21, ldc, c22, ldc, c22, ldc, std::plus<T>());  // C22 = U3 + P5
+    combine(mh, nh, c12, ldc, c11, ldc, c12, ldc, std::plus<T>());  // C12 = U4 + P3
+    product(a22, lda, y, nh, c11, ldc);                             // P4
+    combine(mh, nh, c21, ldc, c11, ldc, c21, ldc, std::minus<T>()); // C21 = U3 - P4
+    product(a12, lda, b21, ldb, c11, ldc);                          // P2
+    combine(mh, nh, x, ldx, c11, ldc, c11, ldc, std::plus<T>());    // C11 = P1 + P2
+
+    peel(m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+// Same recurrence, but every operand sum is formed up front so the seven products are
+// independent pool tasks, each recursing serially in its own slice of the arena.
+template <typename T>
+void strassen_parallel(size_t m, size_t n, size_t k, const T* a, size_t lda, const T* b, size_t ldb,
+                       T* c, size_t ldc, size_t crossover, Arena<T> arena) {
+    size_t mh = m / 2, nh = n / 2, kh = k / 2;
+    const T *a11 = a, *a12 = a + kh, *a21 = a + mh * lda, *a22 = a21 + kh;
+    const T *b11 = b, *b12 = b + nh, *b21 = b + kh * ldb, *b22 = b21 + nh;
+    T *c11 = c, *c12 = c + nh, *c21 = c + mh * ldc, *c22 = c21 + nh;
+
+    T *s1 = arena.take(mh * kh), *s2 = arena.take(mh * kh), *s3 = arena.take(mh * kh), *s4 = arena.take(mh * kh);
+    T *t1 = arena.take(kh * nh), *t2 = arena.take(kh * nh), *t3 = arena.take(kh * nh), *t4 = arena.take(kh * nh);
+    T *p1 = arena.take(mh * nh), *p2 = arena.take(mh * nh), *p4 = arena.take(mh * nh);
+
+    combine(mh, kh, a21, lda, a22, lda, s1, kh, std::plus<T>());
+    combine(mh, kh, s1, kh, a11, lda, s2, kh, std::minus<T>());
+    combine(mh, kh, a11, lda, a21, lda, s3, kh, std::minus<T>());
+    combine(mh, kh, a12, lda, s2, kh, s4, kh, std::minus<T>());
+    combine(kh, nh, b12, ldb, b11, ldb, t1, nh, std::minus<T>());
+    combine(kh, nh, b22, ldb, t1, nh, t2, nh, std::minus<T>());
+    combine(kh, nh, b22, ldb, b12, ldb, t3, nh, std::minus<T>());
+    combine(kh, nh, t2, nh, b21, ldb, t4, nh, std::minus<T>());
+
+    struct Product {
+        const T* p;
+        size_t ldp;
+        const T* q;
+        size_t ldq;
+        T* r;
+        size_t ldr;
+    };
+    const Product products[7] = {
+        {a11, lda, b11, ldb, p1, nh},  // P1
+        {a12, lda, b21, ldb, p2, nh},  // P2
+        {s4, kh, b22, ldb, c11, ldc},  // P3
+        {a22, lda, t4, nh, p4, nh},    // P4
+        {s1, kh, t1, nh, c22, ldc},    // P5
+        {s2, kh, t2, nh, c12, ldc},    // P6
+        {s3, kh, t3, nh, c21, ldc},    // P7
+    };
+    size_t slice = serial_scratch(mh, nh, kh, crossover);
+    ThreadPool::global().parallel_for(7, [&](size_t i) {
+        const Product& pr = products[i];
+        strassen_serial(mh, nh, kh, pr.p, pr.ldp, pr.q, pr.ldq, pr.r, pr.ldr, crossover,
+                        Arena<T>{arena.next + i * slice});
+    });
+
+    combine(mh, nh, p1, nh, c12, ldc, c12, ldc, std::plus<T>());    // U2 = P1 + P6
+    combine(mh, nh, c12, ldc, c21, ldc, c21, ldc, std::plus<T>());  // U3 = U2 + P7
+    combine(mh, nh, c12, ldc, c22, ldc, c12, ldc, std::plus<T>());  // U4 = U2 + P5
+    combine(mh, nh, c21, ldc, c22, ldc, c22, ldc, std::plus<T>());  // C22 = U3 + P5
+    combine(mh, nh, c12, ldc, c11, ldc, c12, ldc, std::plus<T>());  // C12 = U4 + P3
+    combine(mh, nh, c21, ldc, p4, nh, c21, ldc, std::minus<T>());   // C21 = U3 - P4
+    combine(mh, nh, p1, nh, p2, nh, c11, ldc, std::plus<T>());      // C11 = P1 + P2
+
+    peel(m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+}
+
+template <typename T>
+void gemm_strassen(size_t m, size_t n, size_t k,
+                   const T* a, size_t lda,
+                   const T* b, size_t ldb,
+                   T* c, size_t ldc,
+                   size_t crossover) {
+    // Below 2 the halves would never shrink past the recursion test.
+    crossover = std::max<size_t>(crossover == 0 ? default_crossover() : crossover, 2);
+    if (!recurse(m, n, k, crossover)) {
+        gemm_blocked(m, n, k, a, lda, b, ldb, c, ldc);
+        return;
+    }
+
+    bool parallel = ThreadPool::global().size() > 1 && !ThreadPool::in_task();
+    size_t needed = parallel ? parallel_scratch(m, n, k, crossover) : serial_scratch(m, n, k, crossover);
+
+    thread_local std::vector<T> scratch;
+    if (scratch.size() < needed) {
+        scratch.resize(needed);
+    }
+
+    if (parallel) {
+        strassen_parallel(m, n, k, a, lda, b, ldb, c, ldc, crossover, Arena<T>{scratch.data()});
+    } else {
+        strassen_serial(m, n, k, a, lda, b, ldb, c, ldc, crossover, Arena<T>{scratch.data()});
+    }
+}
+
+template void gemm_strassen<float>(size_t, size_t, size_t, const float*, size_t, const float*, size_t,
+                                   float*, size_t, size_t);
+template void gemm_strassen<double>(size_t, size_t, size_t, const double*, size_t, const double*, size_t,
+                                    double*, size_t, size_t);
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sched.h>
+
+#include "../include/ThreadPool.h"
+#include "../include/check.hpp"
+
+namespace {
+
+// Set while the thread is executing pool tasks; nested parallel_for calls then run inline.
+thread_local bool inside_job = false;
+
+size_t default_pool_size() {
+    if (const char* value = std::getenv("MATRIX_NUM_THREADS")) {
+        long requested = std::strtol(value, nullptr, 10);
+        if (requested > 0) {
+            return static_cast<size_t>(requested);
+        }
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0) {
+        return std::max(1, CPU_COUNT(&cpus));
+    }
+    return 1;
+}
+
+bool default_pin_threads() {
+    const char* value = std::getenv("MATRIX_PIN_THREADS");
+    return value != nullptr && std::strtol(value, nullptr, 10) != 0;
+}
+
+uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+pthread_mutex_t global_mutex = PTHREAD_MUTEX_INITIALIZER;
+std::unique_ptr<ThreadPool> global_pool;
+
+}
+
+ThreadPool::ThreadPool(size_t num_threads, bool pin_threads)
+    : _job(nullptr), _participants(0), _generation(0), _stop(false), _pinned(pin_threads),
+      _deques(num_threads), _counters(num_threads) {
+    if (num_threads == 0) {
+        throw std::invalid_argument("Thread pool size must be positive");
+    }
+    check_result(pthread_mutex_init(&_submit_mutex, nullptr));
+    check_result(pthread_mutex_init(&_mutex, nullptr));
+    check_result(pthread_cond_init(&_work_ready, nullptr));
+    check_result(pthread_cond_init(&_work_done, nullptr));
+
+    std::vector<int> cpus;
+    if (pin_threads) {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        check(sched_getaffinity(0, sizeof(allowed), &allowed));
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+
+    _threads.resize(num_threads - 1);
+    _worker_args.resize(num_threads - 1);
+    for (size_t i = 0; i < _threads.size(); ++i) {
+        _worker_args[i] = {this, i};
+
+        // Bind before the thread starts so that nothing it touches lands on another node.
+        pthread_attr_t attr;
+        check_result(pthread_attr_init(&attr));
+        if (!cpus.empty()) {
+            cpu_set_t cpu;
+            CPU_ZERO(&cpu);
+            CPU_SET(cpus[(i + 1) % cpus.size()], &cpu);
+            check_result(pthread_attr_setaffinity_np(&attr, sizeof(cpu), &cpu));
+        }
+        check_result(pthread_create(&_threads[i], &attr, worker_main, &_worker_args[i]));
+        check_result(pthread_attr_destroy(&attr));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    check_result(pthread_mutex_lock(&_mutex));
+    _stop = true;
+    check_result(pthread_cond_broadcast(&_work_ready));
+    check_result(pthread_mutex_unlock(&_mutex));
+
+    for (pthread_t thread : _threads) {
+        check_result(pthread_join(thread, nullptr));
+    }
+
+    check_result(pthread_cond_destroy(&_work_done));
+    check_result(pthread_cond_destroy(&_work_ready));
+    check_result(pthread_mutex_destroy(&_mutex));
+    check_result(pthread_mutex_destroy(&_submit_mutex));
+}
+
+size_t ThreadPool::size() const {
+    return _threads.size() + 1;
+}
+
+bool ThreadPool::pinned() const {
+    return _pinned;
+}
+
+void* ThreadPool::worker_main(void* arg) {
+    WorkerArgs* args = static_cast<WorkerArgs*>(arg);
+    ThreadPool& pool = *args->pool;
+    inside_job = true;
+
+    // Start from the constructor's generation, not the current one: a job may already have
+    // been submitted before this thread got to run, and it still counts on us.
+    size_t seen = 0;
+    check_result(pthread_mutex_lock(&pool._mutex));
+    while (true) {
+        while (!pool._stop && pool._generation == seen)
+            check_result(pthread_cond_wait(&pool._work_ready, &pool._mutex));
+        if (pool._stop) {
+            break;
+        }
+        seen = pool._generation;
+
+        // Worker i is participant i + 1; the submitting thread is participant 0.
+        if (args->index + 1 >= pool._participants) {
+            continue;
+        }
+        Job& job = *pool._job;
+        check_result(pthread_mutex_unlock(&pool._mutex));
+
+        pool.run(job, args->index + 1);
+
+        check_result(pthread_mutex_lock(&pool._mutex));
+        if (--job.active == 0) {
+            check_result(pthread_cond_signal(&pool._work_done));
+        }
+    }
+    check_result(pthread_mutex_unlock(&pool._mutex));
+    return nullptr;
+}
+
+void ThreadPool::run(Job& job, size_t self) {
+    Counters& counters = _counters[self];
+    uint64_t busy = 0;
+
+    auto execute = [&](size_t index) {
+        uint64_t start = now_ns();
+        try {
+            (*job.task)(index);
+        } catch (...) {
+            check_result(pthread_mutex_lock(&_mutex));
+            if (!job.error) {
+                job.error = std::current_exception();
+            }
+            check_result(pthread_mutex_unlock(&_mutex));
+        }
+        busy += now_ns() - start;
+        counters.tasks.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    size_t index;
+    while (_deques[self].pop(index)) {
+        execute(index);
+    }
+
+    // Own block is drained: steal from the top of the other deques, starting at a
+    // per-thread pseudo-random victim so thieves do not all hit the same one. No task is
+    // pushed during a job, so a sweep that finds every deque empty means we are done.
+    size_t participants = job.busy_ns.size();
+    uint64_t seed = (self + 1) * 0x9E3779B97F4A7C15ull ^ now_ns();
+    while (true) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+
+        bool contended = false;
+        bool stolen = false;
+        for (size_t i = 0; i < participants && !stolen; ++i) {
+            size_t victim = (seed + i) % participants;
+            if (victim == self) {
+                continue;
+            }
+            switch (_deques[victim].steal(index)) {
+            case WorkDeque::Steal::Taken:
+                stolen = true;
+                break;
+            case WorkDeque::Steal::Lost:
+                contended = true;
+                break;
+            case WorkDeque::Steal::Empty:
+                break;
+            }
+        }
+
+        if (stolen) {
+            counters.steals.fetch_add(1, std::memory_order_relaxed);
+            execute(index);
+            while (_deques[self].pop(index)) {
+                execute(index);
+            }
+        } else if (contended) {
+            counters.failed_steals.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            break;
+        }
+    }
+
+    job.busy_ns[self] = busy;
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& task, size_t max_workers) {
+    if (count == 0) {
+        return;
+    }
+    size_t participants = std::min({max_workers, size(), count});
+    if (participants <= 1 || inside_job) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    Job job;
+    job.task = &task;
+    job.busy_ns.assign(participants, 0);
+    job.active = participants;
+
+    check_result(pthread_mutex_lock(&_submit_mutex));
+
+    // Contiguous blocks keep neighbouring tiles on one thread; pushing them in reverse
+    // makes the owner pop its block in order while thieves take from the far end.
+    for (size_t p = 0; p < participants; ++p) {
+        size_t begin = count * p / participants;
+        size_t end = count * (p + 1) / participants;
+        _deques[p].reset(end - begin);
+        for (size_t i = end; i > begin; --i) {
+            _deques[p].push(i - 1);
+        }
+    }
+
+    uint64_t start = now_ns();
+    check_result(pthread_mutex_lock(&_mutex));
+    _job = &job;
+    _participants = participants;
+    ++_generation;
+    check_result(pthread_cond_broadcast(&_work_ready));
+    check_result(pthread_mutex_unlock(&_mutex));
+
+    inside_job = true;
+    run(job, 0);
+    inside_job = false;
+
+    check_result(pthread_mutex_lock(&_mutex));
+    --job.active;
+    while (job.active > 0)
+        check_result(pthread_cond_wait(&_work_done, &_mutex));
+    _job = nullptr;
+    _participants = 0;
+    check_result(pthread_mutex_unlock(&_mutex));
+
+    uint64_t wall = now_ns() - start;
+    for (size_t p = 0; p < participants; ++p) {
+        uint64_t busy = std::min(job.busy_ns[p], wall);
+        _counters[p].busy_ns.fetch_add(busy, std::memory_order_relaxed);
+        _counters[p].idle_ns.fetch_add(wall - busy, std::memory_order_relaxed);
+    }
+    check_result(pthread_mutex_unlock(&_submit_mutex));
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+std::vector<ThreadPool::WorkerStats> ThreadPool::stats() const {
+    std::vector<WorkerStats> result;
+    result.reserve(_counters.size());
+    for (const Counters& counters : _counters) {
+        result.push_back({counters.tasks.load(std::memory_order_relaxed),
+                          counters.steals.load(std::memory_order_relaxed),
+                          counters.failed_steals.load(std::memory_order_relaxed),
+                          counters.busy_ns.load(std::memory_order_relaxed) * 1e-9,
+                          counters.idle_ns.load(std::memory_order_relaxed) * 1e-9});
+    }
+    return result;
+}
+
+void ThreadPool::reset_stats() {
+    for (Counters& counters : _counters) {
+        counters.tasks.store(0, std::memory_order_relaxed);
+        counters.steals.store(0, std::memory_order_relaxed);
+        counters.failed_steals.store(0, std::memory_order_relaxed);
+        counters.busy_ns.store(0, std::memory_order_relaxed);
+        counters.idle_ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+ThreadPool& ThreadPool::global() {
+    check_result(pthread_mutex_lock(&global_mutex));
+    if (!global_pool) {
+        global_pool = std::make_unique<ThreadPool>(default_pool_size(), default_pin_threads());
+    }
+    ThreadPool& pool = *global_pool;
+    check_result(pthread_mutex_unlock(&global_mutex));
+    return pool;
+}
+
+void ThreadPool::set_global_size(size_t num_threads) {
+    set_global_size(num_threads, default_pin_threads());
+}
+
+void ThreadPool::set_global_size(size_t num_threads, bool pin_threads) {
+    auto pool = std::make_unique<ThreadPool>(num_threads, pin_threads);
+    check_result(pthread_mutex_lock(&global_mutex));
+    global_pool.swap(pool);
+    check_result(pthread_mutex_unlock(&global_mutex));
+}
+
+bool ThreadPool::in_task() {
+    return inside_job;
+}
@@ -1,10 +1,20 @@
+import struct
+
 import numpy as np
 
+HEADER = struct.Struct('<8sIIQQIIQI12x')
+DTYPES = {1: np.float64, 2: np.float32, 3: np.int8, 4: np.int32}
+
 
 def read_matrix_from_file(filename, size):
-    """Чтение матрицы из бинарного файла"""
+    """Чтение матрицы из бинарного файла (версионный формат или старый сырой дамп)"""
     with open(filename, 'rb') as f:
-        data = np.fromfile(f, dtype=np.float64)
+        raw = f.read()
+    if raw[:8] == b'SPMATRIX':
+        _, _, _, rows, cols, dtype, _, offset, _ = HEADER.unpack_from(raw)
+        data = np.frombuffer(raw, dtype=DTYPES[dtype], offset=offset)
+        return data.reshape((rows, cols)).astype(np.float64)
+    data = np.frombuffer(raw, dtype=np.float64)
     return data.reshape((size, size))
 
 
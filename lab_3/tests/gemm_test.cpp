@@ -0,0 +1,207 @@
+// Checks the blocked GEMM paths against multiply_reference on every ISA the CPU can run,
+// for each Matrix element type (int8_t accumulating into int32_t), and Strassen-Winograd
+// for the floating-point ones; batched products item by item.
+// The shapes are chosen so that no dimension is a multiple of the register tile (MR x NR)
+// or of the cache blocks (MC, KC, NC), and operands are also taken as blocks of larger
+// matrices so that lda/ldb/ldc differ from the widths.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "Gemm.h"
+#include "Matrix.h"
+#include "MatrixBatch.h"
+
+namespace {
+
+struct Shape {
+    size_t m;
+    size_t n;
+    size_t k;
+};
+
+// MC = 96, KC = 256 and NC = 2048 in Gemm.cpp; register tiles are at most 16 wide.
+constexpr Shape SHAPES[] = {
+    {1, 1, 1}, {3, 5, 2}, {7, 13, 9}, {17, 31, 33}, {97, 67, 259}, {193, 45, 515}, {5, 2053, 11},
+};
+
+// Batched items: each fixed-extent kernel (n of 4, 8, 16, 32 or 64, square or not), odd
+// sizes on the generic small kernel, and n past GEMM_BATCH_MAX_N on gemm_blocked.
+constexpr Shape BATCH_SHAPES[] = {
+    {1, 1, 1}, {4, 4, 4}, {8, 8, 8}, {8, 8, 5}, {16, 16, 16}, {5, 32, 3}, {64, 64, 64}, {13, 7, 9}, {3, 65, 2},
+};
+constexpr size_t BATCH_COUNT = 37;
+
+constexpr GemmIsa ISAS[] = {GemmIsa::Generic, GemmIsa::Sse2, GemmIsa::Avx2, GemmIsa::Avx512};
+
+// Inputs are in [-MAX, MAX]. Integer products are exact (MAX keeps alpha * a * b + beta * c
+// inside int32); floating-point rounding differs between the blocked and reference
+// summation orders and grows at most linearly with k.
+template <typename T>
+constexpr T MAX = std::is_floating_point_v<T> ? T(1) : T(100);
+
+// slack widens the tolerance for algorithms that trade accuracy for speed.
+template <typename T>
+bool close(T actual, T expected, size_t k, size_t slack) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::abs(actual - expected) <= std::numeric_limits<T>::epsilon() * static_cast<T>(k + 1) * 64 * slack;
+    } else {
+        return actual == expected;
+    }
+}
+
+template <typename T>
+bool same(const std::string& what, const Shape& s, std::type_identity_t<ConstMatrixView<T>> actual,
+          const Matrix<T>& expected, size_t slack = 1) {
+    for (size_t i = 0; i < expected.rows(); ++i) {
+        for (size_t j = 0; j < expected.cols(); ++j) {
+            if (!close(actual(i, j), expected(i, j), s.k, slack)) {
+                std::cerr << gemm_isa_name() << " " << what << " " << s.m << "x" << s.n << "x" << s.k << ": ("
+                          << i << ", " << j << ") is " << +actual(i, j) << ", expected " << +expected(i, j) << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename T>
+void copy_into(MatrixView<T> dst, const Matrix<T>& src) {
+    for (size_t i = 0; i < src.rows(); ++i) {
+        for (size_t j = 0; j < src.cols(); ++j) {
+            dst(i, j) = src(i, j);
+        }
+    }
+}
+
+template <typename T>
+bool check_products(const Shape& s, uint64_t seed) {
+    using Acc = gemm_acc_t<T>;
+    Matrix<T> a(s.m, s.k);
+    Matrix<T> b(s.k, s.n);
+    a.fill_random(-MAX<T>, MAX<T>, seed);
+    b.fill_random(-MAX<T>, MAX<T>, seed + 1);
+    Matrix<Acc> expected = a.multiply_reference(b);
+
+    bool ok = same("multiply", s, a.multiply(b).view(), expected);
+    ok = same("parallel_multiply", s, a.parallel_multiply(b).view(), expected) && ok;
+    ok = same("parallel_multiply(3)", s, a.parallel_multiply(b, 3).view(), expected) && ok;
+
+    // The same operands as windows of larger matrices, the product into one as well.
+    Matrix<T> a_outer(s.m + 3, s.k + 5);
+    Matrix<T> b_outer(s.k + 2, s.n + 7);
+    Matrix<Acc> c_outer(s.m + 1, s.n + 3);
+    copy_into(a_outer.block(3, 5, s.m, s.k), a);
+    copy_into(b_outer.block(2, 7, s.k, s.n), b);
+    Matrix<T>::parallel_multiply(a_outer.block(3, 5, s.m, s.k), b_outer.block(2, 7, s.k, s.n),
+                                 c_outer.block(1, 3, s.m, s.n));
+    ok = same("strided parallel_multiply", s, c_outer.block(1, 3, s.m, s.n), expected) && ok;
+    return ok;
+}
+
+// c = alpha * a * b + beta * c, against the reference product scaled by hand.
+template <typename T>
+bool check_gemm(const Shape& s, uint64_t seed) {
+    Matrix<T> a(s.m, s.k);
+    Matrix<T> b(s.k, s.n);
+    Matrix<T> c(s.m, s.n);
+    a.fill_random(-MAX<T>, MAX<T>, seed);
+    b.fill_random(-MAX<T>, MAX<T>, seed + 1);
+    c.fill_random(-MAX<T>, MAX<T>, seed + 2);
+    T alpha = T(3);
+    T beta = T(-2);
+
+    Matrix<T> expected = a.multiply_reference(b);
+    for (size_t i = 0; i < s.m; ++i) {
+        for (size_t j = 0; j < s.n; ++j) {
+            expected(i, j) = alpha * expected(i, j) + beta * c(i, j);
+        }
+    }
+    c.gemm(alpha, a, b, beta);
+    return same("gemm", s, c.view(), expected);
+}
+
+// Strassen-Winograd at the default crossover (a plain blocked product at these sizes) and at
+// a tiny one that recurses several levels, peeling odd edges at each.
+template <typename T>
+bool check_strassen(const Shape& s, uint64_t seed) {
+    Matrix<T> a(s.m, s.k);
+    Matrix<T> b(s.k, s.n);
+    a.fill_random(-MAX<T>, MAX<T>, seed);
+    b.fill_random(-MAX<T>, MAX<T>, seed + 1);
+    Matrix<T> expected = a.multiply_reference(b);
+
+    bool ok = same("strassen_multiply", s, a.strassen_multiply(b).view(), expected);
+    ok = same("strassen_multiply(8)", s, a.strassen_multiply(b, 8).view(), expected, 16) && ok;
+    return ok;
+}
+
+// Every item of MatrixBatch::multiply against gemm_reference on that item alone.
+template <typename T>
+bool check_batched(const Shape& s, uint64_t seed) {
+    using Acc = gemm_acc_t<T>;
+    MatrixBatch<T> a(BATCH_COUNT, s.m, s.k);
+    MatrixBatch<T> b(BATCH_COUNT, s.k, s.n);
+    a.fill_random(-MAX<T>, MAX<T>, seed);
+    b.fill_random(-MAX<T>, MAX<T>, seed + 1);
+
+    MatrixBatch<Acc> expected(BATCH_COUNT, s.m, s.n);
+    for (size_t i = 0; i < BATCH_COUNT; ++i) {
+        gemm_reference(s.m, s.n, s.k, a[i].data(), s.k, b[i].data(), s.n, expected[i].data(), s.n);
+    }
+
+    bool ok = true;
+    for (size_t num_threads : {size_t(0), size_t(3)}) {
+        MatrixBatch<Acc> c = a.multiply(b, num_threads);
+        for (size_t i = 0; i < BATCH_COUNT && ok; ++i) {
+            ok = same("batched item " + std::to_string(i), s, c[i], Matrix<Acc>(expected[i]));
+        }
+    }
+    return ok;
+}
+
+template <typename T>
+bool check_all_shapes() {
+    bool ok = true;
+    uint64_t seed = 1;
+    for (const Shape& s : SHAPES) {
+        ok = check_products<T>(s, seed) && ok;
+        if constexpr (std::is_same_v<T, gemm_acc_t<T>>) {
+            ok = check_gemm<T>(s, seed) && ok;
+        }
+        if constexpr (std::is_floating_point_v<T>) {
+            ok = check_strassen<T>(s, seed) && ok;
+        }
+        seed += 3;
+    }
+    for (const Shape& s : BATCH_SHAPES) {
+        ok = check_batched<T>(s, seed) && ok;
+        seed += 2;
+    }
+    return ok;
+}
+
+}
+
+int main() {
+    bool ok = true;
+    for (GemmIsa isa : ISAS) {
+        try {
+            gemm_set_isa(isa);
+        } catch (const std::invalid_argument&) {
+            continue;  // not supported by this CPU
+        }
+        ok = check_all_shapes<double>() && ok;
+        ok = check_all_shapes<float>() && ok;
+        ok = check_all_shapes<int32_t>() && ok;
+        ok = check_all_shapes<int8_t>() && ok;
+    }
+    gemm_set_isa(GemmIsa::Auto);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+// Regression test: a matrix mapped ReadOnly (the open_mapped default) must be readable
+// through every accessor, not only through a const handle. The non-const overloads used to
+// throw std::logic_error, so `Matrix<> m = open_mapped(f); m(0, 0);` failed.
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "Matrix.h"
+#include "MatrixExpr.h"
+
+namespace {
+
+const std::string FILENAME = "mapped_matrix_test.bin";
+
+bool check_mapped_reads(const Matrix<>& expected) {
+    Matrix<> mapped = Matrix<>::open_mapped(FILENAME);
+    if (!mapped.is_mapped() || mapped.rows() != expected.rows() || mapped.cols() != expected.cols()) {
+        std::cerr << "mapped matrix has the wrong shape\n";
+        return false;
+    }
+
+    // Each of these resolves to a non-const overload.
+    double* values = mapped.data();
+    MatrixView<double> view = mapped.view();
+    MatrixView<double> block = mapped.block(1, 2, 3, 4);
+    for (size_t i = 0; i < expected.rows(); ++i) {
+        for (size_t j = 0; j < expected.cols(); ++j) {
+            double want = expected(i, j);
+            if (mapped(i, j) != want || values[i * mapped.cols() + j] != want || view(i, j) != want) {
+                std::cerr << "element (" << i << ", " << j << ") differs\n";
+                return false;
+            }
+        }
+    }
+    if (block(0, 0) != expected(1, 2) || block(2, 3) != expected(3, 5)) {
+        std::cerr << "block reads the wrong elements\n";
+        return false;
+    }
+
+    // Expressions take a view of their operands as well.
+    Matrix<> doubled = mapped + mapped;
+    if (doubled(3, 3) != 2 * expected(3, 3)) {
+        std::cerr << "expression over the mapping differs\n";
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main() {
+    Matrix<> expected(7, 9);
+    expected.fill_random(-1.0, 1.0, 42);
+    expected.write_to_file(FILENAME);
+
+    bool ok = false;
+    try {
+        ok = check_mapped_reads(expected);
+    } catch (const std::exception& e) {
+        std::cerr << "reading a mapped matrix threw: " << e.what() << "\n";
+    }
+    std::remove(FILENAME.c_str());
+    return ok ? 0 : 1;
+}
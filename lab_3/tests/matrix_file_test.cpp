@@ -0,0 +1,93 @@
+// Regression test: a header whose payload_offset is not page aligned must be rejected.
+// parse_matrix_header only checked the offset against the header and file sizes, so a file
+// rewritten with payload_offset = 65 was mapped and handed out a misaligned double*.
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Matrix.h"
+#include "MatrixFile.h"
+
+namespace {
+
+const std::string FILENAME = "matrix_file_test.bin";
+
+constexpr size_t ROWS = 5;
+constexpr size_t COLS = 3;
+
+// Writes matrix to FILENAME, then moves its payload to payload_offset and says so in the
+// header.
+void write_moved(const Matrix<>& matrix, size_t payload_offset) {
+    matrix.write_to_file(FILENAME);
+
+    std::vector<char> bytes(MATRIX_FILE_ALIGNMENT + ROWS * COLS * sizeof(double));
+    FILE* file = std::fopen(FILENAME.c_str(), "rb");
+    size_t read = std::fread(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+    if (read != bytes.size()) {
+        throw std::runtime_error("unexpected size of " + FILENAME);
+    }
+
+    MatrixFileHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    header.payload_offset = payload_offset;
+
+    std::vector<char> moved(payload_offset + ROWS * COLS * sizeof(double), 0);
+    std::memcpy(moved.data(), &header, sizeof(header));
+    std::memcpy(moved.data() + payload_offset, bytes.data() + MATRIX_FILE_ALIGNMENT, ROWS * COLS * sizeof(double));
+    file = std::fopen(FILENAME.c_str(), "wb");
+    std::fwrite(moved.data(), 1, moved.size(), file);
+    std::fclose(file);
+}
+
+template <typename Open>
+bool rejects(const char* what, Open open) {
+    try {
+        open();
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    std::cerr << what << " accepted a misaligned payload\n";
+    return false;
+}
+
+bool check_payload_alignment() {
+    Matrix<> expected(ROWS, COLS);
+    expected.fill_random(-1.0, 1.0, 7);
+    expected.write_to_file(FILENAME);
+
+    const Matrix<> mapped = Matrix<>::open_mapped(FILENAME);
+    if (reinterpret_cast<uintptr_t>(mapped.data()) % MATRIX_FILE_ALIGNMENT != 0 || mapped(4, 2) != expected(4, 2)) {
+        std::cerr << "well-formed file mapped wrongly\n";
+        return false;
+    }
+
+    write_moved(expected, 65);
+    bool ok = rejects("open_mapped", [] { Matrix<>::open_mapped(FILENAME); });
+    ok = rejects("read_from_file", [] { Matrix<>::read_from_file(FILENAME); }) && ok;
+
+    // Any multiple of the alignment is still a valid layout.
+    write_moved(expected, 2 * MATRIX_FILE_ALIGNMENT);
+    if (Matrix<>::read_from_file(FILENAME)(4, 2) != expected(4, 2)) {
+        std::cerr << "payload at two pages read wrongly\n";
+        ok = false;
+    }
+    return ok;
+}
+
+}
+
+int main() {
+    bool ok = false;
+    try {
+        ok = check_payload_alignment();
+    } catch (const std::exception& e) {
+        std::cerr << "unexpected exception: " << e.what() << "\n";
+    }
+    std::remove(FILENAME.c_str());
+    return ok ? 0 : 1;
+}
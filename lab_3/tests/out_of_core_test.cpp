@@ -0,0 +1,111 @@
+// Checks multiply_out_of_core against multiply_reference, with budgets that force several
+// row and column panels (including ragged last ones) as well as a single column panel, and
+// with an input stored in a narrower dtype. Also checks that an output naming one of the
+// inputs is refused without touching that input.
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+#include "Matrix.h"
+#include "OutOfCore.h"
+
+namespace {
+
+const std::string A_FILE = "out_of_core_test_a.bin";
+const std::string B_FILE = "out_of_core_test_b.bin";
+const std::string C_FILE = "out_of_core_test_c.bin";
+const std::string A_LINK = "out_of_core_test_a_link.bin";
+
+constexpr size_t M = 101;
+constexpr size_t N = 53;
+constexpr size_t K = 67;
+
+bool same(const std::string& what, const Matrix<>& actual, const Matrix<>& expected) {
+    if (actual.rows() != expected.rows() || actual.cols() != expected.cols()) {
+        std::cerr << what << ": shape " << actual.rows() << "x" << actual.cols() << "\n";
+        return false;
+    }
+    for (size_t i = 0; i < expected.rows(); ++i) {
+        for (size_t j = 0; j < expected.cols(); ++j) {
+            if (std::abs(actual(i, j) - expected(i, j)) > 1e-12) {
+                std::cerr << what << ": (" << i << ", " << j << ") is " << actual(i, j) << ", expected "
+                          << expected(i, j) << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool check_products() {
+    Matrix<> a(M, K);
+    Matrix<> b(K, N);
+    a.fill_random(-1.0, 1.0, 11);
+    b.fill_random(-1.0, 1.0, 12);
+    a.write_to_file(A_FILE);
+    b.write_to_file(B_FILE);
+    Matrix<> expected = a.multiply_reference(b);
+
+    bool ok = true;
+    // 64 KiB gives 15-column panels of B and 37-row panels of A; 1 MiB holds all of B.
+    for (size_t budget : {size_t(64) << 10, size_t(1) << 20}) {
+        OutOfCoreOptions options;
+        options.memory_budget = budget;
+        OutOfCoreStats stats = multiply_out_of_core<double>(A_FILE, B_FILE, C_FILE, options);
+        std::string what = "budget " + std::to_string(budget) + " (" + std::to_string(stats.panel_rows) + "x" +
+                           std::to_string(stats.panel_cols) + " panels)";
+        ok = same(what, Matrix<>::read_from_file(C_FILE), expected) && ok;
+    }
+
+    // A stored as float32 is widened on the way in; the reference sees the same rounding.
+    a.write_to_file(A_FILE, DType::Float32);
+    Matrix<> a_rounded = Matrix<>::read_from_file(A_FILE);
+    OutOfCoreOptions options;
+    options.memory_budget = size_t(64) << 10;
+    multiply_out_of_core<double>(A_FILE, B_FILE, C_FILE, options);
+    ok = same("float32 A", Matrix<>::read_from_file(C_FILE), a_rounded.multiply_reference(b)) && ok;
+    return ok;
+}
+
+bool check_output_aliasing() {
+    Matrix<> a(M, M);
+    a.fill_random(-1.0, 1.0, 13);
+    a.write_to_file(A_FILE);
+    unlink(A_LINK.c_str());
+    if (link(A_FILE.c_str(), A_LINK.c_str()) != 0) {
+        std::cerr << "cannot create a hard link for the aliasing check\n";
+        return false;
+    }
+
+    bool ok = true;
+    for (const std::string& c_file : {A_FILE, A_LINK}) {
+        try {
+            multiply_out_of_core<double>(A_FILE, A_FILE, c_file);
+            std::cerr << "output " << c_file << " aliasing the input was accepted\n";
+            ok = false;
+        } catch (const std::invalid_argument&) {
+        }
+    }
+    return same("input after refused aliasing", Matrix<>::read_from_file(A_FILE), a) && ok;
+}
+
+}
+
+int main() {
+    bool ok = false;
+    try {
+        ok = check_products();
+        ok = check_output_aliasing() && ok;
+    } catch (const std::exception& e) {
+        std::cerr << "unexpected exception: " << e.what() << "\n";
+        ok = false;
+    }
+    for (const std::string& file : {A_FILE, B_FILE, C_FILE, A_LINK}) {
+        std::remove(file.c_str());
+    }
+    return ok ? 0 : 1;
+}